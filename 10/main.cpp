@@ -2,6 +2,17 @@
 #include <queue>
 #include <thread>
 #include <mutex>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
 
 using namespace std;
 
@@ -25,28 +36,267 @@ public:
     }
 };
 
-class API {
+// Ограниченная очередь многих производителей и потребителей (схема Вьюкова).
+// Каждая ячейка кольца хранит номер последовательности: по нему производитель видит,
+// что ячейка свободна, а потребитель - что она заполнена. Захват ячейки - один CAS по
+// позиции записи или чтения, без блокировок. Ячейки и позиции выровнены по строке кэша,
+// чтобы соседние ячейки не делили строку между ядрами. Блокирующие push/pop сначала
+// коротко крутятся, затем засыпают на condition_variable; мьютекс нужен только
+// при наличии спящих, поэтому на быстром пути его нет.
+template <typename T>
+class BoundedQueue {
 protected:
-    queue<string> requests;
+    static constexpr size_t CACHE_LINE = 64;
+    static constexpr int SPIN_LIMIT = 64;
+
+    struct alignas(CACHE_LINE) Slot {
+        atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T *value() { return reinterpret_cast<T*>(storage); };
+    };
+
+    unique_ptr<Slot[]> slots;
+    size_t mask;
+    alignas(CACHE_LINE) atomic<size_t> enqueuePos{0};
+    alignas(CACHE_LINE) atomic<size_t> dequeuePos{0};
+    alignas(CACHE_LINE) atomic<int> consumersWaiting{0};
+    atomic<int> producersWaiting{0};
+    atomic<bool> closed{false};
+    mutex waitMutex;
+    condition_variable notEmpty;
+    condition_variable notFull;
+    atomic<unsigned> notEmptyGeneration{0};
+    atomic<unsigned> notFullGeneration{0};
+
+    template <typename U>
+    bool tryPushImpl(U &&value) {
+        size_t pos = enqueuePos.load(memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots[pos & mask];
+            size_t seq = slot.sequence.load(memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    new (slot.storage) T(forward<U>(value));
+                    slot.sequence.store(pos + 1, memory_order_release);
+                    wake(consumersWaiting, notEmptyGeneration, notEmpty);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // очередь полна
+            } else {
+                pos = enqueuePos.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    // Будит спящего, если он есть. Барьер парный к барьеру в waitFor: либо спящий
+    // при повторной попытке увидит изменение, либо здесь будет виден его счетчик.
+    // Поколение меняется под мьютексом, поэтому сигнал, пришедший между неудачной
+    // попыткой и засыпанием, не теряется.
+    void wake(atomic<int> &waiting, atomic<unsigned> &generation, condition_variable &cv) {
+        atomic_thread_fence(memory_order_seq_cst);
+        if (waiting.load(memory_order_relaxed) > 0) {
+            lock_guard<mutex> lock(waitMutex);
+            generation.fetch_add(1, memory_order_relaxed);
+            cv.notify_one();
+        }
+    }
+
+    // Повторяет attempt, пока он не удастся, очередь не закроется или не наступит deadline.
+    // attempt выполняется без мьютекса: успешная операция сама будит другую сторону.
+    template <typename Attempt>
+    bool waitFor(Attempt attempt, atomic<int> &waiting, atomic<unsigned> &generation, condition_variable &cv,
+                 const chrono::steady_clock::time_point *deadline) {
+        for (int i = 0; i < SPIN_LIMIT; ++i) {
+            if (attempt()) return true;
+            if (closed.load(memory_order_relaxed)) return attempt();
+            if (i >= SPIN_LIMIT / 2) this_thread::yield();
+        }
+        for (;;) {
+            waiting.fetch_add(1);
+            atomic_thread_fence(memory_order_seq_cst);
+            unsigned seen = generation.load(memory_order_relaxed);
+            bool done = attempt();
+            if (!done && !closed.load()) {
+                unique_lock<mutex> lock(waitMutex);
+                auto changed = [&]() { return generation.load(memory_order_relaxed) != seen || closed.load(); };
+                if (deadline) cv.wait_until(lock, *deadline, changed);
+                else cv.wait(lock, changed);
+            }
+            waiting.fetch_sub(1);
+            if (done) return true;
+            if (closed.load() || (deadline && chrono::steady_clock::now() >= *deadline)) return attempt();
+        }
+    }
+public:
+    // Емкость округляется вверх до степени двойки
+    explicit BoundedQueue(size_t capacity = 1024) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        slots.reset(new Slot[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            slots[i].sequence.store(i, memory_order_relaxed);
+        }
+    }
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue &operator=(const BoundedQueue&) = delete;
+    virtual ~BoundedQueue() {
+        while (tryPop()) {
+        }
+    };
+
+    bool tryPush(const T &value) { return !closed.load(memory_order_relaxed) && tryPushImpl(value); };
+    bool tryPush(T &&value) { return !closed.load(memory_order_relaxed) && tryPushImpl(move(value)); };
+
+    optional<T> tryPop() {
+        size_t pos = dequeuePos.load(memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots[pos & mask];
+            size_t seq = slot.sequence.load(memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    optional<T> result(move(*slot.value()));
+                    slot.value()->~T();
+                    slot.sequence.store(pos + mask + 1, memory_order_release);
+                    wake(producersWaiting, notFullGeneration, notFull);
+                    return result;
+                }
+            } else if (diff < 0) {
+                return nullopt;   // очередь пуста
+            } else {
+                pos = dequeuePos.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    // Ждет свободного места; false - очередь закрыта
+    bool push(T value) {
+        return waitFor([&]() { return !closed.load(memory_order_relaxed) && tryPushImpl(move(value)); },
+                       producersWaiting, notFullGeneration, notFull, nullptr);
+    }
+
+    // Ждет сообщения; nullopt - очередь закрыта и пуста
+    optional<T> pop() {
+        optional<T> result;
+        waitFor([&]() { return (bool)(result = tryPop()); }, consumersWaiting, notEmptyGeneration, notEmpty, nullptr);
+        return result;
+    }
+
+    // Ждет сообщения не дольше timeout
+    template <typename Rep, typename Period>
+    optional<T> popFor(const chrono::duration<Rep, Period> &timeout) {
+        optional<T> result;
+        auto deadline = chrono::steady_clock::now() + timeout;
+        waitFor([&]() { return (bool)(result = tryPop()); }, consumersWaiting, notEmptyGeneration, notEmpty, &deadline);
+        return result;
+    }
+
+    // После закрытия новые сообщения не принимаются, оставшиеся можно дочитать
+    void close() {
+        closed.store(true);
+        lock_guard<mutex> lock(waitMutex);
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    bool isClosed() const { return closed.load(); };
+    size_t capacity() const { return mask + 1; };
+    // Приблизительный размер: при параллельной работе может тут же устареть
+    size_t sizeApprox() const {
+        size_t in = enqueuePos.load(memory_order_relaxed), out = dequeuePos.load(memory_order_relaxed);
+        return in > out ? in - out : 0;
+    }
+};
+
+// Прежняя схема - очередь под одним мьютексом; оставлена для сравнения. Ограничена так же,
+// как кольцо: push ждет места, поэтому обе очереди одинаково притормаживают писателей
+template <typename T>
+class MutexQueue {
+protected:
+    queue<T> items;
+    size_t limit;
     mutex mtx;
+    condition_variable notEmpty;
+    condition_variable notFull;
+    bool closed = false;
 public:
-    API() {}
-    virtual ~API() {};
-    void enqueueRequest(const string &req) {
-        lock_guard<mutex> lck(mtx);
-        requests.push(req);
+    MutexQueue(size_t capacity = 1024) : limit(max<size_t>(1, capacity)) {}
+    virtual ~MutexQueue() {};
+    bool push(T value) {
+        {
+            unique_lock<mutex> lck(mtx);
+            notFull.wait(lck, [this]() { return closed || items.size() < limit; });
+            if (closed) return false;
+            items.push(move(value));
+        }
+        notEmpty.notify_one();
+        return true;
+    }
+    optional<T> tryPop() {
+        optional<T> result;
+        {
+            lock_guard<mutex> lck(mtx);
+            if (items.empty()) return nullopt;
+            result.emplace(move(items.front()));
+            items.pop();
+        }
+        notFull.notify_one();
+        return result;
     }
-    string dequeueRequest() {
-        lock_guard<mutex> lck(mtx);
-        if (!requests.empty()) {
-            string req = requests.front();
-            requests.pop();
-            return req;
+    optional<T> pop() {
+        optional<T> result;
+        {
+            unique_lock<mutex> lck(mtx);
+            notEmpty.wait(lck, [this]() { return closed || !items.empty(); });
+            if (items.empty()) return nullopt;
+            result.emplace(move(items.front()));
+            items.pop();
         }
-        return "";
+        notFull.notify_one();
+        return result;
+    }
+    void close() {
+        {
+            lock_guard<mutex> lck(mtx);
+            closed = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
     }
 };
 
+class API {
+protected:
+    BoundedQueue<string> requests;
+public:
+    API(size_t capacity = 1024)
+        : requests(capacity) {}
+    virtual ~API() {};
+    // Ждет места в очереди; false - API остановлен. Только когда запросы разбирает другой поток
+    bool enqueueRequest(const string &req) {
+        return requests.push(req);
+    }
+    bool tryEnqueueRequest(const string &req) {
+        return requests.tryPush(req);
+    }
+    // nullopt - запросов нет; пустая строка - допустимый запрос
+    optional<string> dequeueRequest() {
+        return requests.tryPop();
+    }
+    optional<string> waitRequest() {
+        return requests.pop();
+    }
+    template <typename Rep, typename Period>
+    optional<string> waitRequest(const chrono::duration<Rep, Period> &timeout) {
+        return requests.popFor(timeout);
+    }
+    void shutdown() { requests.close(); };
+};
+
 class Database {
 protected:
     string dbName;
@@ -61,24 +311,30 @@ public:
 
 class MessageQueue {
 protected:
-    queue<string> messages;
-    mutex mtx;
+    BoundedQueue<string> messages;
 public:
-    MessageQueue() {}
+    MessageQueue(size_t capacity = 1024)
+        : messages(capacity) {}
     virtual ~MessageQueue() {};
-    void pushMessage(const string &msg) {
-        lock_guard<mutex> lck(mtx);
-        messages.push(msg);
+    // Ждет места в очереди; только когда сообщения разбирает другой поток
+    bool pushMessage(const string &msg) {
+        return messages.push(msg);
     }
-    string popMessage() {
-        lock_guard<mutex> lck(mtx);
-        if (!messages.empty()) {
-            string msg = messages.front();
-            messages.pop();
-            return msg;
-        }
-        return "";
+    bool tryPushMessage(const string &msg) {
+        return messages.tryPush(msg);
+    }
+    // nullopt - сообщений нет
+    optional<string> popMessage() {
+        return messages.tryPop();
     }
+    optional<string> waitMessage() {
+        return messages.pop();
+    }
+    template <typename Rep, typename Period>
+    optional<string> waitMessage(const chrono::duration<Rep, Period> &timeout) {
+        return messages.popFor(timeout);
+    }
+    void close() { messages.close(); };
 };
 
 class LoadBalancer {
@@ -105,8 +361,9 @@ public:
     Client(API *a)
         : api(a) {}
     virtual ~Client() {};
-    void makeRequest(const string &req) {
-        api->enqueueRequest(req);
+    // Не ждет места: false - очередь API полна или API остановлен, запрос не принят
+    bool makeRequest(const string &req) {
+        return api->tryEnqueueRequest(req);
     }
 };
 
@@ -132,25 +389,95 @@ int main() {
     // Клиент
     Client client(&api);
 
-    // Отправка запросов клиентом
-    client.makeRequest("Запрос #1");
-    client.makeRequest("Запрос #2");
+    // Отправка запросов клиентом. Программа однопоточная, поэтому очереди заполняются без ожидания:
+    // блокирующая вставка в полную очередь ждала бы читателя, которого нет
+    for (const char *req : {"Запрос #1", "Запрос #2"}) {
+        if (!client.makeRequest(req)) cerr << "Запрос '" << req << "' отклонен: очередь API полна\n";
+    }
 
-    // Обработка запросов сервисом
-    while (true) {
-        string request = api.dequeueRequest();
-        if (request.empty()) break;
+    // Обработка запросов сервисом; если очередь сообщений полна, сначала сохраняем накопленное
+    while (auto request = api.dequeueRequest()) {
         Service *selectedSvc = lb.selectService();
-        selectedSvc->processRequest(request);
-        mq.pushMessage(selectedSvc->getServiceID() + " обработал запрос: " + request);
+        selectedSvc->processRequest(*request);
+        string message = selectedSvc->getServiceID() + " обработал запрос: " + *request;
+        while (!mq.tryPushMessage(message)) {
+            if (auto msg = mq.popMessage()) db.storeData(*msg);
+        }
     }
 
     // Извлечение сообщений из очереди
-    while (true) {
-        string msg = mq.popMessage();
-        if (msg.empty()) break;
-        db.storeData(msg);
+    while (auto msg = mq.popMessage()) {
+        db.storeData(*msg);
+    }
+
+    // Пустое сообщение больше не путается с отсутствием сообщений, ожидание ограничено сроком
+    mq.tryPushMessage("");
+    auto empty = mq.popMessage();
+    auto none = mq.waitMessage(chrono::milliseconds(20));
+    cout << "\nПустое сообщение: " << (empty ? "получено" : "потеряно") << ", ожидание 20 мс: "
+         << (none ? "неожиданное сообщение" : "сообщений нет") << "\n\n";
+
+    // Сравнение с очередью под мьютексом: половина потоков пишет, половина читает.
+    // В сообщении - время отправки, по нему считается задержка доставки. Обе очереди вмещают
+    // по 1024 сообщения и одинаково притормаживают писателей, различается только синхронизация.
+    auto bench = [](auto &q, int threads, int items, double &opsPerSec, double &p50us, double &p99us) {
+        typedef chrono::steady_clock Clock;
+        int producers = threads / 2, consumers = threads - producers;
+        vector<vector<int64_t>> latencies(consumers);
+        auto t0 = Clock::now();
+        vector<thread> pool;
+        for (int c = 0; c < consumers; ++c) {
+            pool.emplace_back([&, c]() {
+                auto &lat = latencies[c];
+                while (auto sent = q.pop()) {
+                    lat.push_back(Clock::now().time_since_epoch().count() - *sent);
+                }
+            });
+        }
+        vector<thread> writers;
+        for (int p = 0; p < producers; ++p) {
+            writers.emplace_back([&, p]() {
+                int share = items / producers + (p < items % producers);
+                for (int i = 0; i < share; ++i) {
+                    q.push((int64_t)Clock::now().time_since_epoch().count());
+                }
+            });
+        }
+        for (auto &t : writers) {
+            t.join();
+        }
+        q.close();
+        for (auto &t : pool) {
+            t.join();
+        }
+        double seconds = chrono::duration<double>(Clock::now() - t0).count();
+        vector<int64_t> all;
+        for (auto &lat : latencies) {
+            all.insert(all.end(), lat.begin(), lat.end());
+        }
+        opsPerSec = all.size() / seconds;
+        auto percentile = [&](double q) {
+            size_t k = (size_t)(q * (all.size() - 1));
+            nth_element(all.begin(), all.begin() + k, all.end());
+            return chrono::duration<double, micro>(chrono::nanoseconds(all[k])).count();
+        };
+        p50us = percentile(0.50);
+        p99us = percentile(0.99);
+        return all.size() == (size_t)items;
+    };
+    cout << "Потоков | кольцо: оп/с, p50 мкс, p99 мкс | мьютекс: оп/с, p50 мкс, p99 мкс\n";
+    const int items = 100000;
+    bool complete = true;
+    // Меньше двух потоков не бывает: нужен хотя бы один писатель и один читатель
+    for (int threads : {2, 4, 8, 16, 32, 64}) {
+        double ringOps, ringP50, ringP99, lockOps, lockP50, lockP99;
+        BoundedQueue<int64_t> ring(1024);
+        MutexQueue<int64_t> locked(1024);
+        complete = bench(ring, threads, items, ringOps, ringP50, ringP99) && complete;
+        complete = bench(locked, threads, items, lockOps, lockP50, lockP99) && complete;
+        printf("%7d | %10.0f %8.1f %9.1f | %10.0f %8.1f %9.1f\n", threads, ringOps, ringP50, ringP99, lockOps, lockP50, lockP99);
     }
+    cout << "Все сообщения доставлены: " << (complete ? "да" : "НЕТ") << "\n";
 
     return 0;
 }
\ No newline at end of file
@@ -2,6 +2,17 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <deque>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <ctime>
+#include <cstdio>
+#include <algorithm>
+#include <queue>
+#include <functional>
+#include <unordered_map>
+#include <climits>
 
 using namespace std;
 
@@ -10,13 +21,19 @@ private:
     string id;
     string name;
     string role;
+    int capacity; // story points за спринт
 public:
-    TeamMember(const string& id, const string& name, const string& role)
-        : id(id), name(name), role(role) {}
+    TeamMember(const string& id, const string& name, const string& role, int capacity = 0)
+        : id(id), name(name), role(role), capacity(capacity) {}
+    
+    void setCapacity(int points) {
+        capacity = points;
+    }
     
     string getId() const { return id; }
     string getName() const { return name; }
     string getRole() const { return role; }
+    int getCapacity() const { return capacity; }
 };
 
 class UserStory {
@@ -25,6 +42,7 @@ private:
     string description;
     string status;
     int storyPoints;
+    vector<UserStory*> dependencies;
 public:
     UserStory(const string& id, const string& description, int storyPoints)
         : id(id), description(description), storyPoints(storyPoints), status("To Do") {}
@@ -33,10 +51,15 @@ public:
         status = newStatus;
     }
     
+    void addDependency(UserStory* story) {
+        dependencies.push_back(story);
+    }
+    
     string getId() const { return id; }
     string getDescription() const { return description; }
     int getStoryPoints() const { return storyPoints; }
     string getStatus() const { return status; }
+    const vector<UserStory*>& getDependencies() const { return dependencies; }
 };
 
 class Task {
@@ -66,6 +89,8 @@ public:
     }
     
     string getId() const { return id; }
+    string getStatus() const { return status; }
+    UserStory* getUserStory() const { return userStory; }
     TeamMember* getAssignee() const { return assignee; }
     int getEstimatedHours() const { return estimatedHours; }
     int getActualHours() const { return actualHours; }
@@ -109,8 +134,11 @@ public:
         return total;
     }
     
-    vector<UserStory*> getUserStories() const { return userStories; }
-    vector<Task*> getTasks() const { return tasks; }
+    string getId() const { return id; }
+    string getStartDate() const { return startDate; }
+    string getEndDate() const { return endDate; }
+    const vector<UserStory*>& getUserStories() const { return userStories; }
+    const vector<Task*>& getTasks() const { return tasks; }
 };
 
 class Backlog {
@@ -131,7 +159,7 @@ public:
         }
     }
     
-    vector<UserStory*> getUserStories() const { return userStories; }
+    const vector<UserStory*>& getUserStories() const { return userStories; }
 };
 
 class BurndownChart {
@@ -154,10 +182,489 @@ public:
     }
 };
 
+// Разбивает диапазон [0, n) на равные части и обрабатывает их в отдельных потоках
+template <typename Func>
+void parallelFor(size_t n, unsigned threadCount, Func func) {
+    if (threadCount == 0) threadCount = 1;
+    if (threadCount > n) threadCount = n > 0 ? (unsigned)n : 1;
+    size_t chunk = (n + threadCount - 1) / threadCount;
+    vector<thread> workers;
+    for (unsigned t = 1; t < threadCount; ++t) {
+        size_t begin = t * chunk;
+        size_t end = min(n, begin + chunk);
+        workers.emplace_back(func, begin, end, t);
+    }
+    func(0, min(n, chunk), 0u);
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+string addDays(const string& date, int days) {
+    tm t = {};
+    sscanf(date.c_str(), "%d-%d-%d", &t.tm_year, &t.tm_mon, &t.tm_mday);
+    t.tm_year -= 1900;
+    t.tm_mon -= 1;
+    t.tm_mday += days;
+    t.tm_hour = 12;
+    mktime(&t);
+    char buf[11];
+    strftime(buf, sizeof(buf), "%Y-%m-%d", &t);
+    return buf;
+}
+
+int daysBetween(const string& from, const string& to) {
+    tm a = {}, b = {};
+    sscanf(from.c_str(), "%d-%d-%d", &a.tm_year, &a.tm_mon, &a.tm_mday);
+    sscanf(to.c_str(), "%d-%d-%d", &b.tm_year, &b.tm_mon, &b.tm_mday);
+    a.tm_year -= 1900; a.tm_mon -= 1; a.tm_hour = 12;
+    b.tm_year -= 1900; b.tm_mon -= 1; b.tm_hour = 12;
+    return (int)((mktime(&b) - mktime(&a)) / (24 * 60 * 60));
+}
+
+class SprintAnalytics {
+public:
+    struct MemberStats {
+        int sprints = 0;          // спринтов, в которых у участника были задачи
+        int completedTasks = 0;
+        long long estimatedHours = 0;
+        long long actualHours = 0;
+        long long completedHours = 0;
+
+        double velocity() const { return sprints ? (double)completedHours / sprints : 0.0; }
+        double accuracy() const { return actualHours ? (double)estimatedHours / actualHours : 0.0; }
+    };
+
+    struct Forecast {
+        int trials = 0;
+        int remainingPoints = 0;
+        double meanSprints = 0;
+        int p50 = -1, p85 = -1, p95 = -1;   // -1: бэклог не закрывается за maxSprints
+        string p50Date, p85Date, p95Date;
+    };
+
+private:
+    vector<Sprint*> history;
+    vector<int> velocities;   // закрытые story points по каждому спринту
+    unsigned threadCount;
+    static const int maxSprints = 1000;
+
+public:
+    SprintAnalytics(const vector<Sprint*>& history, unsigned threads = thread::hardware_concurrency())
+        : history(history), threadCount(threads ? threads : 1) {
+        velocities.resize(history.size());
+        parallelFor(history.size(), threadCount, [this](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; ++i) {
+                velocities[i] = this->history[i]->getCompletedStoryPoints();
+            }
+        });
+    }
+
+    const vector<int>& getVelocities() const { return velocities; }
+
+    double averageVelocity() const {
+        if (velocities.empty()) return 0.0;
+        long long total = 0;
+        for (int v : velocities) total += v;
+        return (double)total / velocities.size();
+    }
+
+    // Каждый поток считает свою часть истории в локальную карту, затем карты сливаются
+    map<string, MemberStats> memberStats() const {
+        vector<map<string, MemberStats>> partial(threadCount);
+        parallelFor(history.size(), threadCount, [&](size_t begin, size_t end, unsigned t) {
+            map<string, MemberStats>& local = partial[t];
+            map<string, int> lastSprint;
+            for (size_t i = begin; i < end; ++i) {
+                for (const Task* task : history[i]->getTasks()) {
+                    if (!task->getAssignee()) continue;
+                    const string& memberId = task->getAssignee()->getId();
+                    MemberStats& stats = local[memberId];
+                    auto seen = lastSprint.find(memberId);
+                    if (seen == lastSprint.end() || seen->second != (int)i) {
+                        stats.sprints++;
+                        lastSprint[memberId] = (int)i;
+                    }
+                    stats.estimatedHours += task->getEstimatedHours();
+                    stats.actualHours += task->getActualHours();
+                    if (task->getStatus() == "Done") {
+                        stats.completedTasks++;
+                        stats.completedHours += task->getActualHours();
+                    }
+                }
+            }
+        });
+        map<string, MemberStats> result;
+        for (const auto& local : partial) {
+            for (const auto& entry : local) {
+                MemberStats& stats = result[entry.first];
+                stats.sprints += entry.second.sprints;
+                stats.completedTasks += entry.second.completedTasks;
+                stats.estimatedHours += entry.second.estimatedHours;
+                stats.actualHours += entry.second.actualHours;
+                stats.completedHours += entry.second.completedHours;
+            }
+        }
+        return result;
+    }
+
+    // Отношение оценки к факту по всем задачам: 1.0 - точная оценка, < 1.0 - недооценка
+    double estimateAccuracy() const {
+        long long estimated = 0, actual = 0;
+        for (const auto& entry : memberStats()) {
+            estimated += entry.second.estimatedHours;
+            actual += entry.second.actualHours;
+        }
+        return actual ? (double)estimated / actual : 0.0;
+    }
+
+    // Монте-Карло: скорость каждого будущего спринта берется случайно из истории
+    Forecast forecastBacklog(const Backlog& backlog, int trials = 100000, unsigned seed = 42) const {
+        Forecast forecast;
+        forecast.trials = trials;
+        for (const UserStory* story : backlog.getUserStories()) {
+            if (story->getStatus() != "Done") {
+                forecast.remainingPoints += story->getStoryPoints();
+            }
+        }
+        if (velocities.empty() || trials <= 0) return forecast;
+
+        vector<vector<int>> histograms(threadCount, vector<int>(maxSprints + 2, 0));
+        int remaining = forecast.remainingPoints;
+        parallelFor((size_t)trials, threadCount, [&](size_t begin, size_t end, unsigned t) {
+            mt19937 rng(seed + t * 7919u);
+            uniform_int_distribution<size_t> pick(0, velocities.size() - 1);
+            vector<int>& histogram = histograms[t];
+            for (size_t trial = begin; trial < end; ++trial) {
+                int left = remaining;
+                int sprints = 0;
+                while (left > 0 && sprints <= maxSprints) {
+                    left -= velocities[pick(rng)];
+                    sprints++;
+                }
+                histogram[left > 0 ? maxSprints + 1 : sprints]++;
+            }
+        });
+
+        vector<int> histogram(maxSprints + 2, 0);
+        for (const auto& local : histograms) {
+            for (int i = 0; i <= maxSprints + 1; ++i) histogram[i] += local[i];
+        }
+
+        long long cumulative = 0;
+        double sum = 0;
+        for (int i = 0; i <= maxSprints; ++i) {
+            sum += (double)i * histogram[i];
+            cumulative += histogram[i];
+            if (forecast.p50 < 0 && cumulative * 100 >= 50LL * trials) forecast.p50 = i;
+            if (forecast.p85 < 0 && cumulative * 100 >= 85LL * trials) forecast.p85 = i;
+            if (forecast.p95 < 0 && cumulative * 100 >= 95LL * trials) forecast.p95 = i;
+        }
+        forecast.meanSprints = cumulative ? sum / cumulative : 0.0;
+
+        if (!history.empty()) {
+            const Sprint* last = history.back();
+            int length = daysBetween(last->getStartDate(), last->getEndDate()) + 1;
+            if (forecast.p50 >= 0) forecast.p50Date = addDays(last->getEndDate(), forecast.p50 * length);
+            if (forecast.p85 >= 0) forecast.p85Date = addDays(last->getEndDate(), forecast.p85 * length);
+            if (forecast.p95 >= 0) forecast.p95Date = addDays(last->getEndDate(), forecast.p95 * length);
+        }
+        return forecast;
+    }
+};
+
+// Автоматическое планирование спринта: заполняет емкость команды историями из бэклога.
+// История попадает в спринт только вместе со всеми своими зависимостями, то есть план -
+// замкнутое вниз множество в графе зависимостей. Связанные группы историй независимы и
+// объединяются рюкзаком с группами. Внутри группы-дерева (у каждой истории не больше одной
+// открытой зависимости в бэклоге) таблица "емкость -> лучшая ценность" считается точно:
+// таблицы детей сливаются в таблицу родителя, поэтому план дает максимум очков, при равенстве -
+// более приоритетные истории. В группе, где у истории несколько открытых зависимостей, точного
+// быстрого решения нет: берутся префиксы топологического порядка с учетом приоритета (эвристика).
+class SprintPlanner {
+private:
+    static constexpr long long NONE = LLONG_MIN / 4;   // недостижимая ценность
+
+    struct Group {
+        int root = -1;            // корень дерева; -1 - группа решается префиксами
+        vector<int> stories;      // для префиксов: индексы в порядке взятия
+        vector<int> weights;      // варианты группы по возрастанию веса
+        vector<long long> values;
+    };
+
+    // Узел дерева зависимостей: таблица ценностей поддерева, в котором взят сам узел,
+    // и выбор при слиянии этого узла в таблицу родителя
+    struct TreeNode {
+        vector<int> children;
+        vector<long long> table;  // table[c] - лучшая ценность с весом не больше c, NONE - нельзя
+        vector<int> split;        // split[c] - сколько емкости отдано этому поддереву при слиянии
+    };
+
+    vector<UserStory*> stories;   // кандидаты в порядке приоритета
+    int capacity;
+
+    // Очки в старших битах; при равенстве очков выигрывает план, в котором очки
+    // приходятся на более приоритетные истории (каждое очко весит n - позиция истории)
+    long long valueOf(int i) const {
+        long long points = stories[i]->getStoryPoints();
+        return (points << 40) + points * (long long)(stories.size() - i);
+    }
+
+    // Таблица узла v по таблицам детей (дети уже посчитаны)
+    void solveNode(int v, vector<TreeNode>& nodes) const {
+        TreeNode& node = nodes[v];
+        vector<long long> merged(1, 0);   // дети без самого узла: merged[c] - с весом не больше c
+        for (int child : node.children) {
+            TreeNode& sub = nodes[child];
+            int have = (int)merged.size() - 1, add = (int)sub.table.size() - 1;
+            int size = min(capacity, have + add) + 1;
+            vector<long long> next(size, NONE);
+            sub.split.assign(size, 0);
+            for (int c = 0; c < size; ++c) {
+                for (int k = 0; k <= min(c, add); ++k) {
+                    long long taken = k == 0 ? 0 : sub.table[k];
+                    if (taken == NONE) continue;
+                    long long value = merged[min(c - k, have)] + taken;
+                    if (value > next[c]) {
+                        next[c] = value;
+                        sub.split[c] = k;
+                    }
+                }
+            }
+            merged.swap(next);
+            vector<long long>().swap(sub.table);
+        }
+        int weight = stories[v]->getStoryPoints();
+        int have = (int)merged.size() - 1;
+        node.table.assign(min(capacity, have + weight) + 1, NONE);
+        for (int c = weight; c < (int)node.table.size(); ++c) {
+            node.table[c] = merged[min(c - weight, have)] + valueOf(v);
+        }
+    }
+
+    // Истории поддерева root, выбранные при емкости budget
+    void collect(int root, int budget, const vector<TreeNode>& nodes, vector<int>& selected) const {
+        vector<pair<int, int>> stack{{root, budget}};
+        while (!stack.empty()) {
+            int v = stack.back().first, c = stack.back().second;
+            stack.pop_back();
+            selected.push_back(v);
+            c -= stories[v]->getStoryPoints();
+            const vector<int>& children = nodes[v].children;
+            for (size_t j = children.size(); j-- > 0;) {
+                const vector<int>& split = nodes[children[j]].split;
+                c = min(c, (int)split.size() - 1);
+                int k = split[c];
+                if (k > 0) stack.emplace_back(children[j], k);
+                c -= k;
+            }
+        }
+    }
+
+    vector<Group> buildGroups(vector<int>& topoRank, vector<TreeNode>& nodes) const {
+        size_t n = stories.size();
+        unordered_map<const UserStory*, int> index;
+        for (size_t i = 0; i < n; ++i) {
+            index[stories[i]] = (int)i;
+        }
+
+        // Блокируем истории, зависящие от незавершенных историй вне бэклога, и их потомков
+        vector<vector<int>> dependents(n);
+        vector<int> pending(n, 0);
+        vector<int> parentStory(n, -1);   // единственная открытая зависимость, -2 - их несколько
+        vector<bool> blocked(n, false);
+        for (size_t i = 0; i < n; ++i) {
+            for (const UserStory* dep : stories[i]->getDependencies()) {
+                if (dep->getStatus() == "Done") continue;
+                auto it = index.find(dep);
+                if (it == index.end()) {
+                    blocked[i] = true;
+                } else {
+                    dependents[it->second].push_back((int)i);
+                    pending[i]++;
+                    parentStory[i] = parentStory[i] == -1 || parentStory[i] == it->second ? it->second : -2;
+                }
+            }
+        }
+
+        // Топологическая сортировка Кана: из готовых историй первой идет самая приоритетная
+        priority_queue<int, vector<int>, greater<int>> ready;
+        for (size_t i = 0; i < n; ++i) {
+            if (pending[i] == 0) ready.push((int)i);
+        }
+        vector<int> order;
+        order.reserve(n);
+        topoRank.assign(n, -1);
+        while (!ready.empty()) {
+            int i = ready.top();
+            ready.pop();
+            topoRank[i] = (int)order.size();
+            order.push_back(i);
+            for (int next : dependents[i]) {
+                if (blocked[i]) blocked[next] = true;
+                if (--pending[next] == 0) ready.push(next);
+            }
+        }
+        // Истории в циклах зависимостей в order не попадают и не планируются
+
+        vector<int> parent(n);
+        for (size_t i = 0; i < n; ++i) parent[i] = (int)i;
+        function<int(int)> find = [&](int x) {
+            while (parent[x] != x) {
+                parent[x] = parent[parent[x]];
+                x = parent[x];
+            }
+            return x;
+        };
+        for (int i : order) {
+            if (blocked[i]) continue;
+            for (int next : dependents[i]) {
+                if (!blocked[next]) parent[find(i)] = find(next);
+            }
+        }
+
+        vector<Group> groups;
+        vector<int> groupOf(n, -1);
+        vector<bool> tree;
+        for (int i : order) {
+            if (blocked[i]) continue;
+            int root = find(i);
+            if (groupOf[root] < 0) {
+                groupOf[root] = (int)groups.size();
+                groups.emplace_back();
+                tree.push_back(true);
+            }
+            Group& group = groups[groupOf[root]];
+            group.stories.push_back(i);
+            if (parentStory[i] == -2) tree[groupOf[root]] = false;
+        }
+
+        nodes.assign(n, TreeNode());
+        vector<bool> excluded(n, false);
+        for (size_t g = 0; g < groups.size(); ++g) {
+            Group& group = groups[g];
+            if (tree[g]) {
+                // Дети раньше родителей: обратный топологический порядок
+                for (int i : group.stories) {
+                    if (parentStory[i] >= 0) nodes[parentStory[i]].children.push_back(i);
+                    else group.root = i;
+                }
+                for (size_t k = group.stories.size(); k-- > 0;) {
+                    solveNode(group.stories[k], nodes);
+                }
+                // Варианты группы - емкости, на которых ценность растет
+                const vector<long long>& table = nodes[group.root].table;
+                long long last = 0;
+                for (int c = 0; c < (int)table.size(); ++c) {
+                    if (table[c] == NONE || table[c] <= last) continue;
+                    last = table[c];
+                    group.weights.push_back(c);
+                    group.values.push_back(table[c]);
+                }
+                group.stories.clear();
+                continue;
+            }
+            // Эвристика: не поместившаяся история пропускается вместе с зависящими от нее,
+            // остальные истории группы продолжают префикс
+            vector<int> prefix;
+            for (int i : group.stories) {
+                int weight = (group.weights.empty() ? 0 : group.weights.back()) + stories[i]->getStoryPoints();
+                if (excluded[i] || weight > capacity) {
+                    excluded[i] = true;
+                    for (int next : dependents[i]) excluded[next] = true;
+                    continue;
+                }
+                prefix.push_back(i);
+                group.weights.push_back(weight);
+                group.values.push_back((group.values.empty() ? 0 : group.values.back()) + valueOf(i));
+            }
+            group.stories.swap(prefix);
+        }
+        return groups;
+    }
+
+public:
+    SprintPlanner(const Backlog& backlog, const vector<TeamMember*>& team) : capacity(0) {
+        for (const TeamMember* member : team) {
+            capacity += member->getCapacity();
+        }
+        for (UserStory* story : backlog.getUserStories()) {
+            if (story->getStatus() != "Done") {
+                stories.push_back(story);
+            }
+        }
+    }
+
+    int getCapacity() const { return capacity; }
+
+    vector<UserStory*> plan() const {
+        vector<int> topoRank;
+        vector<TreeNode> nodes;
+        vector<Group> groups = buildGroups(topoRank, nodes);
+        vector<long long> best(capacity + 1, 0), next(capacity + 1);
+        // choice[g * (capacity + 1) + c] - сколько историй группы g взято при емкости c
+        vector<int> choice(groups.size() * (capacity + 1), 0);
+
+        for (size_t g = 0; g < groups.size(); ++g) {
+            const Group& group = groups[g];
+            const int* weights = group.weights.data();
+            const long long* values = group.values.data();
+            int options = (int)group.weights.size();
+            const long long* from = best.data();
+            long long* to = next.data();
+            int* row = &choice[g * (capacity + 1)];
+            for (int c = 0; c <= capacity; ++c) {
+                long long bestValue = from[c];
+                int bestTaken = 0;
+                for (int k = 0; k < options && weights[k] <= c; ++k) {
+                    long long value = from[c - weights[k]] + values[k];
+                    if (value > bestValue) {
+                        bestValue = value;
+                        bestTaken = k + 1;
+                    }
+                }
+                to[c] = bestValue;
+                row[c] = bestTaken;
+            }
+            best.swap(next);
+        }
+
+        vector<int> selected;
+        int c = capacity;
+        for (size_t g = groups.size(); g-- > 0;) {
+            int taken = choice[g * (capacity + 1) + c];
+            if (taken == 0) continue;
+            const Group& group = groups[g];
+            if (group.root >= 0) {
+                collect(group.root, group.weights[taken - 1], nodes, selected);
+            } else {
+                selected.insert(selected.end(), group.stories.begin(), group.stories.begin() + taken);
+            }
+            c -= group.weights[taken - 1];
+        }
+        // Порядок приоритета, но зависимости всегда раньше зависимых историй
+        sort(selected.begin(), selected.end(), [&](int a, int b) { return topoRank[a] < topoRank[b]; });
+        vector<UserStory*> result;
+        result.reserve(selected.size());
+        for (int i : selected) {
+            result.push_back(stories[i]);
+        }
+        return result;
+    }
+
+    Sprint createSprint(const string& id, const string& name, const string& start, const string& end) const {
+        Sprint sprint(id, name, start, end);
+        for (UserStory* story : plan()) {
+            sprint.addUserStory(story);
+        }
+        return sprint;
+    }
+};
+
 int main() {
     // Создаем членов команды
-    TeamMember dev1("TM001", "Alice", "Developer");
-    TeamMember dev2("TM002", "Bob", "Developer");
+    TeamMember dev1("TM001", "Alice", "Developer", 8);
+    TeamMember dev2("TM002", "Bob", "Developer", 5);
     TeamMember po("TM003", "Charlie", "Product Owner");
     
     // Создаем бэклог
@@ -198,5 +705,170 @@ int main() {
     // Генерируем отчет
     chart.generateChart();
     
+    // Моделируем историю из нескольких тысяч спринтов (несколько команд за 1990-2022 годы)
+    vector<TeamMember*> team = {&dev1, &dev2};
+    deque<UserStory> historyStories;
+    deque<Task> historyTasks;
+    deque<Sprint> historySprints;
+    vector<Sprint*> history;
+    mt19937 rng(2023);
+    for (int i = 0; i < 5000; ++i) {
+        string start = addDays("1990-01-01", (i % 850) * 14);
+        historySprints.emplace_back("SP-H" + to_string(i), "History " + to_string(i), start, addDays(start, 13));
+        Sprint& past = historySprints.back();
+        for (int j = 0; j < 8; ++j) {
+            string storyId = "US-H" + to_string(i) + "-" + to_string(j);
+            historyStories.emplace_back(storyId, "Historical story", 1 + rng() % 8);
+            UserStory& story = historyStories.back();
+            if (rng() % 10 < 8) story.updateStatus("Done");
+            past.addUserStory(&story);
+            for (int k = 0; k < 2; ++k) {
+                int estimate = 2 + rng() % 10;
+                historyTasks.emplace_back(storyId + "-T" + to_string(k), "Historical task", &story, estimate);
+                Task& task = historyTasks.back();
+                task.assignTo(team[rng() % team.size()]);
+                task.logHours(estimate * (70 + (int)(rng() % 70)) / 100);
+                if (story.getStatus() == "Done") task.updateStatus("Done");
+                past.addTask(&task);
+            }
+        }
+    }
+    for (auto& past : historySprints) history.push_back(&past);
+    history.push_back(&sprint);
+    
+    auto analyticsStart = chrono::steady_clock::now();
+    SprintAnalytics analytics(history);
+    auto members = analytics.memberStats();
+    double accuracy = analytics.estimateAccuracy();
+    
+    // Дополняем бэклог, чтобы прогноз был содержательным
+    deque<UserStory> futureStories;
+    for (int i = 0; i < 200; ++i) {
+        futureStories.emplace_back("US-F" + to_string(i), "Future story", 1 + i % 8);
+        backlog.addUserStory(&futureStories.back());
+    }
+    auto forecast = analytics.forecastBacklog(backlog, 200000);
+    auto analyticsMs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - analyticsStart).count();
+    
+    cout << "\nTeam analytics over " << history.size() << " sprints\n";
+    cout << "Average velocity: " << analytics.averageVelocity() << " points/sprint\n";
+    cout << "Estimate accuracy (estimated/actual): " << accuracy << "\n";
+    for (const auto& entry : members) {
+        cout << entry.first << ": " << entry.second.velocity() << " hours/sprint, accuracy "
+             << entry.second.accuracy() << ", " << entry.second.completedTasks << " tasks done\n";
+    }
+    cout << "Forecast for " << forecast.remainingPoints << " remaining points (" << forecast.trials << " trials):\n";
+    cout << "P50: " << forecast.p50 << " sprints (" << forecast.p50Date << ")\n";
+    cout << "P85: " << forecast.p85 << " sprints (" << forecast.p85Date << ")\n";
+    cout << "P95: " << forecast.p95 << " sprints (" << forecast.p95Date << ")\n";
+    cout << "Analytics computed in " << analyticsMs << " ms\n";
+    
+    // Автоматически планируем следующий спринт из бэклога
+    UserStory us3("US003", "As a user, I want to edit my profile", 5);
+    us3.addDependency(&us2);
+    backlog.addUserStory(&us3);
+    SprintPlanner planner(backlog, {&dev1, &dev2, &po});
+    Sprint planned = planner.createSprint("SP002", "Sprint 2", "2023-05-15", "2023-05-28");
+    cout << "\nPlanned sprint (capacity " << planner.getCapacity() << "): " << planned.getTotalStoryPoints() << " points\n";
+    for (const UserStory* story : planned.getUserStories()) {
+        cout << story->getId() << " (" << story->getStoryPoints() << ")\n";
+    }
+    
+    // Проверка на маленьких случайных бэклогах: план сравнивается с полным перебором.
+    // Первый случай - пример, где префиксы приоритетного порядка не оптимальны:
+    // A=2, от нее зависят B=5 и C=3, E=3 независима; при емкости 8 лучший план A+C+E
+    const int examplePoints[] = {2, 5, 3, 3};
+    int suboptimal = 0, infeasible = 0, treeCases = 0;
+    for (int trial = 0; trial < 3000; ++trial) {
+        bool example = trial == 0;
+        int count = example ? 4 : 1 + (int)(rng() % 10);
+        bool dag = !example && trial % 4 == 3;   // каждый четвертый - с несколькими зависимостями
+        vector<UserStory> small;
+        small.reserve(count);   // указатели на истории не должны меняться
+        Backlog smallBacklog;
+        for (int i = 0; i < count; ++i) {
+            int points = example ? examplePoints[i] : 1 + (int)(rng() % 8);
+            small.emplace_back("S" + to_string(i), "Small story", points);
+            if (example) {
+                if (i == 1 || i == 2) small.back().addDependency(&small[0]);
+            } else if (i > 0) {
+                for (int d = 0; d < (dag ? 2 : 1); ++d) {
+                    if (rng() % 2) small.back().addDependency(&small[rng() % i]);
+                }
+            }
+            if (!example && rng() % 8 == 0) small.back().updateStatus("Done");
+            smallBacklog.addUserStory(&small.back());
+        }
+        TeamMember member("TM-S", "Checker", "Developer", example ? 8 : (int)(rng() % 25));
+        SprintPlanner smallPlanner(smallBacklog, {&member});
+        vector<UserStory*> chosen = smallPlanner.plan();
+
+        // План допустим: все открытые зависимости в плане, емкость не превышена
+        int points = 0;
+        for (const UserStory* story : chosen) {
+            points += story->getStoryPoints();
+            for (const UserStory* dep : story->getDependencies()) {
+                if (dep->getStatus() != "Done" && find(chosen.begin(), chosen.end(), dep) == chosen.end()) infeasible++;
+            }
+        }
+        if (points > member.getCapacity()) infeasible++;
+
+        // Перебор всех подмножеств открытых историй
+        int best = 0;
+        for (int mask = 0; mask < (1 << count); ++mask) {
+            int weight = 0;
+            bool closed = true;
+            for (int i = 0; i < count && closed; ++i) {
+                if (!(mask >> i & 1)) continue;
+                if (small[i].getStatus() == "Done") closed = false;
+                weight += small[i].getStoryPoints();
+                for (const UserStory* dep : small[i].getDependencies()) {
+                    int d = (int)(dep - &small[0]);
+                    if (dep->getStatus() != "Done" && !(mask >> d & 1)) closed = false;
+                }
+            }
+            if (closed && weight <= member.getCapacity()) best = max(best, weight);
+        }
+        // Точность обещана только для деревьев зависимостей
+        if (!dag) {
+            treeCases++;
+            if (points != best) suboptimal++;
+        } else if (points > best) {
+            infeasible++;
+        }
+    }
+    cout << "Planner check vs brute force: " << treeCases << " tree backlogs, " << suboptimal
+         << " suboptimal; " << infeasible << " infeasible plans\n";
+    
+    // Бенчмарк планировщика на бэклоге из 10k историй
+    Backlog bigBacklog;
+    deque<UserStory> bigStories;
+    for (int i = 0; i < 10000; ++i) {
+        bigStories.emplace_back("US-B" + to_string(i), "Benchmark story", 1 + rng() % 13);
+        if (i > 0 && rng() % 5 == 0) {
+            bigStories.back().addDependency(&bigStories[rng() % i]);
+        }
+        bigBacklog.addUserStory(&bigStories.back());
+    }
+    deque<TeamMember> bigTeam;
+    vector<TeamMember*> bigTeamPtrs;
+    for (int i = 0; i < 40; ++i) {
+        bigTeam.emplace_back("TM-B" + to_string(i), "Member " + to_string(i), "Developer", 13);
+        bigTeamPtrs.push_back(&bigTeam.back());
+    }
+    const int runs = 10;
+    int plannedPoints = 0;
+    auto planStart = chrono::steady_clock::now();
+    for (int run = 0; run < runs; ++run) {
+        SprintPlanner bigPlanner(bigBacklog, bigTeamPtrs);
+        plannedPoints = 0;
+        for (const UserStory* story : bigPlanner.plan()) {
+            plannedPoints += story->getStoryPoints();
+        }
+    }
+    double planMs = chrono::duration<double, milli>(chrono::steady_clock::now() - planStart).count() / runs;
+    cout << "Planner benchmark: " << bigStories.size() << " stories, capacity " << 40 * 13
+         << ", planned " << plannedPoints << " points in " << planMs << " ms\n";
+    
     return 0;
 }
\ No newline at end of file
@@ -3,9 +3,149 @@
 #include <string>
 #include <ctime>
 #include <map>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <unordered_map>
+#include <climits>
+#include <deque>
+#include <optional>
+#include <memory>
+#include <cstring>
+#include <string_view>
+#include <algorithm>
+#include <shared_mutex>
+#include <cmath>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
 
 using namespace std;
 
+// Время приема кодируется целым числом: номер дня * SLOTS_PER_DAY + номер слота в дне
+const int SLOT_MINUTES = 15;
+const int SLOTS_PER_DAY = 24 * 60 / SLOT_MINUTES;
+const int WORDS_PER_DAY = (SLOTS_PER_DAY + 63) / 64;
+
+// Количество дней с 1970-01-01 (алгоритм days_from_civil)
+int daysFromCivil(int y, int m, int d) {
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+void civilFromDays(int z, int& y, int& m, int& d) {
+    z += 719468;
+    int era = (z >= 0 ? z : z - 146096) / 146097;
+    int doe = z - era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp + (mp < 10 ? 3 : -9);
+    y = yoe + era * 400 + (m <= 2);
+}
+
+// "YYYY-MM-DD" -> номер дня, -1 при ошибке
+int parseDay(const string& date) {
+    int y, m, d;
+    if (sscanf(date.c_str(), "%d-%d-%d", &y, &m, &d) != 3 || m < 1 || m > 12 || d < 1 || d > 31) {
+        return -1;
+    }
+    return daysFromCivil(y, m, d);
+}
+
+// "YYYY-MM-DD HH:MM" -> номер слота, -1 при ошибке или времени не на границе слота
+int parseSlot(const string& dateTime) {
+    int y, mo, d, h, mi;
+    if (sscanf(dateTime.c_str(), "%d-%d-%d %d:%d", &y, &mo, &d, &h, &mi) != 5 ||
+        mo < 1 || mo > 12 || d < 1 || d > 31 || h < 0 || h > 23 || mi < 0 || mi > 59 ||
+        mi % SLOT_MINUTES != 0) {
+        return -1;
+    }
+    return daysFromCivil(y, mo, d) * SLOTS_PER_DAY + (h * 60 + mi) / SLOT_MINUTES;
+}
+
+string formatSlot(int slot) {
+    int y, m, d;
+    civilFromDays(slot / SLOTS_PER_DAY, y, m, d);
+    int minutes = slot % SLOTS_PER_DAY * SLOT_MINUTES;
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d", y, m, d, minutes / 60, minutes % 60);
+    return buf;
+}
+
+// Хранилище со стабильными дескрипторами: элементы не перемещаются при росте,
+// а поколение в дескрипторе отличает удаленный элемент от нового в том же слоте
+struct Handle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+    
+    bool valid() const { return index != UINT32_MAX; }
+};
+
+template <typename T>
+class SlotMap {
+private:
+    deque<optional<T>> items;   // deque не перемещает элементы при добавлении в конец
+    vector<uint32_t> generations;
+    vector<uint32_t> freeSlots;
+    size_t count = 0;
+public:
+    Handle insert(const T& value) {
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+            items[index].emplace(value);
+        } else {
+            index = (uint32_t)items.size();
+            items.emplace_back(value);
+            generations.push_back(0);
+        }
+        count++;
+        return Handle{index, generations[index]};
+    }
+    
+    bool erase(Handle h) {
+        if (!get(h)) return false;
+        items[h.index].reset();
+        generations[h.index]++;
+        freeSlots.push_back(h.index);
+        count--;
+        return true;
+    }
+    
+    T* get(Handle h) {
+        if (h.index >= items.size() || generations[h.index] != h.generation || !items[h.index]) {
+            return nullptr;
+        }
+        return &*items[h.index];
+    }
+    
+    const T* get(Handle h) const {
+        return const_cast<SlotMap*>(this)->get(h);
+    }
+    
+    size_t size() const { return count; }
+};
+
 class Patient {
 private:
     string id;
@@ -27,26 +167,92 @@ private:
     string id;
     string name;
     string specialization;
-    map<string, bool> schedule; // dateTime -> available
+    map<int, array<uint64_t, WORDS_PER_DAY>> schedule; // день -> битовая карта свободных слотов
+    mutable mutex scheduleMutex; // расписание каждого врача блокируется отдельно
+    
+    bool isAvailableLocked(int slot) const {
+        if (slot < 0) return false;
+        auto it = schedule.find(slot / SLOTS_PER_DAY);
+        int bit = slot % SLOTS_PER_DAY;
+        return it != schedule.end() && (it->second[bit / 64] >> (bit % 64) & 1);
+    }
 public:
     Doctor(string id, string name, string specialization)
         : id(id), name(name), specialization(specialization) {}
     
+    Doctor(const Doctor& other)
+        : id(other.id), name(other.name), specialization(other.specialization) {
+        lock_guard<mutex> lck(other.scheduleMutex);
+        schedule = other.schedule;
+    }
+    
+    Doctor& operator=(const Doctor& other) {
+        if (this != &other) {
+            scoped_lock lck(scheduleMutex, other.scheduleMutex);
+            id = other.id;
+            name = other.name;
+            specialization = other.specialization;
+            schedule = other.schedule;
+        }
+        return *this;
+    }
+    
+    void addAvailability(int slot) {
+        if (slot < 0) return;
+        lock_guard<mutex> lck(scheduleMutex);
+        auto it = schedule.find(slot / SLOTS_PER_DAY);
+        if (it == schedule.end()) {
+            it = schedule.emplace(slot / SLOTS_PER_DAY, array<uint64_t, WORDS_PER_DAY>{}).first;
+        }
+        int bit = slot % SLOTS_PER_DAY;
+        it->second[bit / 64] |= 1ULL << (bit % 64);
+    }
+    
     void addAvailability(string dateTime) {
-        schedule[dateTime] = true;
+        addAvailability(parseSlot(dateTime));
+    }
+    
+    bool isAvailable(int slot) const {
+        lock_guard<mutex> lck(scheduleMutex);
+        return isAvailableLocked(slot);
     }
     
     bool isAvailable(string dateTime) const {
-        auto it = schedule.find(dateTime);
-        return it != schedule.end() && it->second;
+        return isAvailable(parseSlot(dateTime));
+    }
+    
+    // Проверка и занятие слота выполняются под одной блокировкой
+    bool bookAppointment(int slot) {
+        lock_guard<mutex> lck(scheduleMutex);
+        if (!isAvailableLocked(slot)) return false;
+        int bit = slot % SLOTS_PER_DAY;
+        schedule[slot / SLOTS_PER_DAY][bit / 64] &= ~(1ULL << (bit % 64));
+        return true;
     }
     
     bool bookAppointment(string dateTime) {
-        if (isAvailable(dateTime)) {
-            schedule[dateTime] = false;
-            return true;
+        return bookAppointment(parseSlot(dateTime));
+    }
+    
+    // Первый свободный слот в [from, to), -1 если такого нет
+    int findFirstFree(int from, int to) const {
+        if (from < 0 || from >= to) return -1;
+        lock_guard<mutex> lck(scheduleMutex);
+        for (auto it = schedule.lower_bound(from / SLOTS_PER_DAY);
+             it != schedule.end() && it->first * SLOTS_PER_DAY < to; ++it) {
+            int base = it->first * SLOTS_PER_DAY;
+            int start = max(from - base, 0);
+            int end = min(to - base, SLOTS_PER_DAY);
+            for (int w = start / 64; w * 64 < end; ++w) {
+                uint64_t bits = it->second[w];
+                if (w == start / 64) bits &= ~0ULL << (start % 64);
+                if (bits == 0) continue;
+                int bit = w * 64 + __builtin_ctzll(bits);
+                if (bit < end) return base + bit;
+                break;
+            }
         }
-        return false;
+        return -1;
     }
     
     string getId() const { return id; }
@@ -66,16 +272,24 @@ public:
     Appointment(string id, Patient* patient, Doctor* doctor, string dateTime, string reason)
         : id(id), patient(patient), doctor(doctor), dateTime(dateTime), reason(reason), status("Scheduled") {}
     
-    void cancel() {
+    // Слот освобождается только при первой отмене запланированного приема,
+    // иначе повторная отмена освободила бы слот, уже занятый другим пациентом
+    bool cancel() {
+        if (status != "Scheduled") return false;
         status = "Cancelled";
         doctor->addAvailability(dateTime);
+        return true;
     }
     
     void complete() {
         status = "Completed";
     }
     
+    string getId() const { return id; }
     string getStatus() const { return status; }
+    string getDateTime() const { return dateTime; }
+    string getReason() const { return reason; }
+    Patient* getPatient() const { return patient; }
     Doctor* getDoctor() const { return doctor; }
 };
 
@@ -88,13 +302,15 @@ private:
     string treatment;
     time_t date;
 public:
-    MedicalRecord(string id, Patient* patient, Doctor* doctor, string diagnosis, string treatment)
-        : id(id), patient(patient), doctor(doctor), diagnosis(diagnosis), treatment(treatment) {
-        date = time(nullptr);
-    }
+    MedicalRecord(string id, Patient* patient, Doctor* doctor, string diagnosis, string treatment,
+                  time_t date = time(nullptr))
+        : id(id), patient(patient), doctor(doctor), diagnosis(diagnosis), treatment(treatment), date(date) {}
     
+    string getId() const { return id; }
+    Patient* getPatient() const { return patient; }
     string getDiagnosis() const { return diagnosis; }
     string getTreatment() const { return treatment; }
+    time_t getDate() const { return date; }
 };
 
 class Prescription {
@@ -106,18 +322,23 @@ private:
     string instructions;
     time_t date;
 public:
-    Prescription(string id, Patient* patient, Doctor* doctor, vector<string> meds, string instructions)
-        : id(id), patient(patient), doctor(doctor), medications(meds), instructions(instructions) {
-        date = time(nullptr);
-    }
+    Prescription(string id, Patient* patient, Doctor* doctor, vector<string> meds, string instructions,
+                 time_t date = time(nullptr))
+        : id(id), patient(patient), doctor(doctor), medications(meds), instructions(instructions), date(date) {}
     
     void addMedication(string med) {
         medications.push_back(med);
     }
     
+    string getId() const { return id; }
+    Patient* getPatient() const { return patient; }
     vector<string> getMedications() const { return medications; }
+    string getInstructions() const { return instructions; }
+    time_t getDate() const { return date; }
 };
 
+class BillingLedger;
+
 class Billing {
 private:
     string id;
@@ -125,91 +346,1035 @@ private:
     double amount;
     string description;
     bool isPaid;
+    time_t date;
+    Doctor* doctor;
 public:
-    Billing(string id, Patient* patient, double amount, string description)
-        : id(id), patient(patient), amount(amount), description(description), isPaid(false) {}
+    Billing(string id, Patient* patient, double amount, string description, time_t date = time(nullptr),
+            Doctor* doctor = nullptr)
+        : id(id), patient(patient), amount(amount), description(description), isPaid(false), date(date),
+          doctor(doctor) {}
     
-    void pay() {
-        isPaid = true;
-    }
+    // Оплата идет через журнал счетов: остаток долга гасится там, флаг счета - его отражение
+    void pay(BillingLedger& ledger);
     
+    string getId() const { return id; }
+    Patient* getPatient() const { return patient; }
+    Doctor* getDoctor() const { return doctor; }
     double getAmount() const { return amount; }
+    string getDescription() const { return description; }
+    time_t getDate() const { return date; }
     bool paid() const { return isPaid; }
 };
 
+// Общий буфер для текста истории: строки копируются один раз в большие блоки,
+// записи истории хранят только ссылки на них. Блоки не перемещаются.
+struct TextRef {
+    uint32_t chunk = 0;
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+class TextArena {
+private:
+    static constexpr size_t CHUNK_SIZE = 1 << 20;
+    vector<unique_ptr<char[]>> chunks;
+    size_t used = CHUNK_SIZE;   // занято в последнем блоке
+    size_t totalBytes = 0;
+    unordered_map<string_view, TextRef> interned;
+public:
+    TextRef store(string_view text) {
+        if (text.empty()) return TextRef();
+        if (used + text.size() > CHUNK_SIZE) {
+            chunks.emplace_back(new char[max(CHUNK_SIZE, text.size())]);
+            used = 0;
+        }
+        TextRef ref{(uint32_t)chunks.size() - 1, (uint32_t)used, (uint32_t)text.size()};
+        memcpy(chunks.back().get() + used, text.data(), text.size());
+        // Слишком длинная строка заняла отдельный блок целиком
+        used = text.size() > CHUNK_SIZE ? CHUNK_SIZE : used + text.size();
+        totalBytes += text.size();
+        return ref;
+    }
+    
+    // Повторяющийся текст (диагнозы, схемы лечения, лекарства) хранится один раз: ключи таблицы
+    // указывают на уже сохраненные в арене строки, которые никогда не перемещаются.
+    // Только для полей с небольшим числом различных значений - уникальный текст раздувает таблицу
+    TextRef intern(string_view text) {
+        if (text.empty()) return TextRef();
+        auto it = interned.find(text);
+        if (it != interned.end()) return it->second;
+        TextRef ref = store(text);
+        interned.emplace(view(ref), ref);
+        return ref;
+    }
+    
+    string_view view(TextRef ref) const {
+        if (ref.length == 0) return string_view();
+        return string_view(chunks[ref.chunk].get() + ref.offset, ref.length);
+    }
+    
+    size_t bytes() const { return totalBytes; }
+};
+
+enum class HistoryKind : uint8_t { Appointment, Record, Prescription, Bill };
+
+struct HistoryEntry {
+    int64_t timestamp;
+    uint64_t sequence;  // порядок добавления, различает записи с одинаковым временем
+    HistoryKind kind;
+    double amount;      // сумма счета, для остальных записей 0
+    TextRef id;
+    TextRef text;       // причина приема, диагноз, лекарства или описание счета
+    TextRef details;    // время приема, лечение или инструкции
+};
+
+// Позиция для постраничного чтения: следующая страница начинается строго после нее
+struct HistoryCursor {
+    int64_t timestamp = INT64_MIN;
+    uint64_t sequence = 0;
+};
+
+struct HistoryPage {
+    vector<HistoryEntry> entries;
+    HistoryCursor next;
+    bool hasMore = false;
+};
+
+// История каждого пациента хранится отдельно и упорядочена по времени, поэтому
+// запросы затрагивают только записи одного пациента. Записи только дописываются в конец;
+// записи задним числом упорядочиваются при ближайшем чтении истории этого пациента
+class MedicalHistory {
+private:
+    struct PatientLog {
+        vector<HistoryEntry> entries;
+        size_t sorted = 0;   // длина упорядоченного начала entries
+    };
+    
+    mutable unordered_map<string, PatientLog> byPatient;   // чтение досортировывает хвост
+    TextArena arena;
+    uint64_t nextSequence = 0;
+    size_t count = 0;
+    mutable mutex historyMutex;
+    
+    static bool before(const HistoryEntry& e, const HistoryCursor& c) {
+        return e.timestamp < c.timestamp || (e.timestamp == c.timestamp && e.sequence <= c.sequence);
+    }
+    
+    static bool earlier(const HistoryEntry& a, const HistoryEntry& b) {
+        return a.timestamp < b.timestamp || (a.timestamp == b.timestamp && a.sequence < b.sequence);
+    }
+    
+    // Упорядоченные записи пациента; вызывается под historyMutex
+    const vector<HistoryEntry>* sortedLog(const string& patientId) const {
+        auto it = byPatient.find(patientId);
+        if (it == byPatient.end()) return nullptr;
+        PatientLog& log = it->second;
+        if (log.sorted < log.entries.size()) {
+            auto middle = log.entries.begin() + log.sorted;
+            sort(middle, log.entries.end(), earlier);
+            inplace_merge(log.entries.begin(), middle, log.entries.end(), earlier);
+            log.sorted = log.entries.size();
+        }
+        return &log.entries;
+    }
+    
+    // internText / internDetails - поле из небольшого набора значений, хранится один раз
+    void append(const string& patientId, HistoryKind kind, time_t timestamp, double amount, const string& id,
+                const string& text, bool internText, const string& details, bool internDetails) {
+        lock_guard<mutex> lck(historyMutex);
+        HistoryEntry entry{timestamp, nextSequence++, kind, amount, arena.store(id),
+                           internText ? arena.intern(text) : arena.store(text),
+                           internDetails ? arena.intern(details) : arena.store(details)};
+        PatientLog& log = byPatient[patientId];
+        bool inOrder = log.entries.empty() || log.entries.back().timestamp <= timestamp;
+        log.entries.push_back(entry);
+        if (inOrder && log.sorted + 1 == log.entries.size()) log.sorted++;
+        count++;
+    }
+public:
+    // Прием попадает в историю в момент записи, время самого приема хранится в details
+    void add(const Appointment& appt) {
+        append(appt.getPatient()->getId(), HistoryKind::Appointment, time(nullptr), 0,
+               appt.getId(), appt.getReason(), false, appt.getDateTime(), false);
+    }
+    
+    void add(const MedicalRecord& record) {
+        append(record.getPatient()->getId(), HistoryKind::Record, record.getDate(), 0,
+               record.getId(), record.getDiagnosis(), true, record.getTreatment(), true);
+    }
+    
+    void add(const Prescription& rx) {
+        string meds;
+        for (const auto& med : rx.getMedications()) {
+            if (!meds.empty()) meds += ", ";
+            meds += med;
+        }
+        append(rx.getPatient()->getId(), HistoryKind::Prescription, rx.getDate(), 0,
+               rx.getId(), meds, true, rx.getInstructions(), false);
+    }
+    
+    void add(const Billing& bill) {
+        append(bill.getPatient()->getId(), HistoryKind::Bill, bill.getDate(), bill.getAmount(),
+               bill.getId(), bill.getDescription(), false, "", false);
+    }
+    
+    // До limit записей пациента строго после курсора
+    HistoryPage page(const string& patientId, HistoryCursor after, size_t limit) const {
+        lock_guard<mutex> lck(historyMutex);
+        HistoryPage result;
+        const vector<HistoryEntry>* entries = sortedLog(patientId);
+        if (!entries || limit == 0) return result;
+        const vector<HistoryEntry>& log = *entries;
+        auto first = partition_point(log.begin(), log.end(),
+                                     [&](const HistoryEntry& e) { return before(e, after); });
+        auto last = first + min(limit, (size_t)(log.end() - first));
+        result.entries.assign(first, last);
+        result.hasMore = last != log.end();
+        result.next = after;
+        if (!result.entries.empty()) {
+            result.next.timestamp = result.entries.back().timestamp;
+            result.next.sequence = result.entries.back().sequence;
+        }
+        return result;
+    }
+    
+    // Записи пациента с временем в [from, to)
+    vector<HistoryEntry> range(const string& patientId, time_t from, time_t to) const {
+        lock_guard<mutex> lck(historyMutex);
+        const vector<HistoryEntry>* entries = sortedLog(patientId);
+        if (!entries) return {};
+        const vector<HistoryEntry>& log = *entries;
+        auto first = partition_point(log.begin(), log.end(),
+                                     [&](const HistoryEntry& e) { return e.timestamp < from; });
+        auto last = partition_point(first, log.end(),
+                                    [&](const HistoryEntry& e) { return e.timestamp < to; });
+        return vector<HistoryEntry>(first, last);
+    }
+    
+    // Блоки буфера не освобождаются, поэтому строки остаются действительными
+    string_view text(TextRef ref) const {
+        lock_guard<mutex> lck(historyMutex);
+        return arena.view(ref);
+    }
+    
+    size_t size() const {
+        lock_guard<mutex> lck(historyMutex);
+        return count;
+    }
+    
+    size_t textBytes() const {
+        lock_guard<mutex> lck(historyMutex);
+        return arena.bytes();
+    }
+};
+
+// Суммы в копейках/центах, чтобы остатки складывались точно
+long long toCents(double amount) {
+    return llround(amount * 100);
+}
+
+// "123", "123.4" или "123.45" -> центы, -1 при ошибке.
+// Больше 15 цифр в целой части не принимается: сумма в центах должна помещаться в long long
+long long parseCents(string_view text) {
+    long long units = 0;
+    size_t i = 0;
+    if (text.empty()) return -1;
+    for (; i < text.size() && text[i] != '.'; ++i) {
+        if (text[i] < '0' || text[i] > '9' || i == 15) return -1;
+        units = units * 10 + (text[i] - '0');
+    }
+    long long cents = 0;
+    int digits = 0;
+    if (i < text.size()) {
+        for (++i; i < text.size(); ++i, ++digits) {
+            if (digits == 2 || text[i] < '0' || text[i] > '9') return -1;
+            cents = cents * 10 + (text[i] - '0');
+        }
+    }
+    if (digits == 1) cents *= 10;
+    return units * 100 + cents;
+}
+
+string formatCents(long long cents) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%s%lld.%02lld", cents < 0 ? "-" : "", llabs(cents) / 100, llabs(cents) % 100);
+    return buf;
+}
+
+// Журнал счетов с текущими остатками долга по пациентам и врачам.
+// Оплаты изменяют остатки атомарно, поэтому пакеты платежей применяются параллельно;
+// общая дебиторская задолженность читается одной атомарной переменной.
+class BillingLedger {
+private:
+    struct BillState {
+        Billing bill;
+        atomic<long long> outstanding;
+        atomic<long long>* patientBalance;
+        atomic<long long>* doctorBalance;
+        
+        BillState(const Billing& bill, long long cents, atomic<long long>* patientBalance,
+                  atomic<long long>* doctorBalance)
+            : bill(bill), outstanding(cents), patientBalance(patientBalance), doctorBalance(doctorBalance) {}
+    };
+    
+    deque<BillState> bills;                            // адреса не меняются при добавлении
+    deque<atomic<long long>> balances;                 // остатки пациентов и врачей
+    unordered_map<string, BillState*> billById;
+    unordered_map<string, atomic<long long>*> patientBalances;
+    unordered_map<string, atomic<long long>*> doctorBalances;
+    atomic<long long> receivables{0};
+    mutable shared_mutex ledgerMutex; // исключительно - новые счета, разделяемо - оплаты и чтение
+    
+    atomic<long long>* balanceFor(unordered_map<string, atomic<long long>*>& index, const string& id) {
+        auto it = index.find(id);
+        if (it != index.end()) return it->second;
+        balances.emplace_back(0);
+        index[id] = &balances.back();
+        return &balances.back();
+    }
+    
+    // -1, если счета нет
+    long long applyLocked(const string& billId, long long cents) {
+        auto it = billById.find(billId);
+        if (it == billById.end()) return -1;
+        if (cents <= 0) return 0;
+        BillState& state = *it->second;
+        long long current = state.outstanding.load();
+        long long applied;
+        do {
+            applied = min(current, cents);
+            if (applied == 0) return 0;
+        } while (!state.outstanding.compare_exchange_weak(current, current - applied));
+        state.patientBalance->fetch_sub(applied);
+        if (state.doctorBalance) state.doctorBalance->fetch_sub(applied);
+        receivables.fetch_sub(applied);
+        return applied;
+    }
+    
+    static long long getOrZero(const unordered_map<string, atomic<long long>*>& index, const string& id) {
+        auto it = index.find(id);
+        return it != index.end() ? it->second->load() : 0;
+    }
+public:
+    struct RemittanceResult {
+        size_t lines = 0;
+        size_t rejected = 0;          // неизвестный счет или ошибка формата
+        long long appliedCents = 0;
+        long long unappliedCents = 0; // переплата сверх остатка
+    };
+    
+    void add(const Billing& bill) {
+        unique_lock<shared_mutex> lck(ledgerMutex);
+        if (billById.count(bill.getId())) return;
+        long long cents = bill.paid() ? 0 : toCents(bill.getAmount());
+        atomic<long long>* patient = balanceFor(patientBalances, bill.getPatient()->getId());
+        atomic<long long>* doctor = bill.getDoctor() ? balanceFor(doctorBalances, bill.getDoctor()->getId()) : nullptr;
+        bills.emplace_back(bill, cents, patient, doctor);
+        billById[bill.getId()] = &bills.back();
+        patient->fetch_add(cents);
+        if (doctor) doctor->fetch_add(cents);
+        receivables.fetch_add(cents);
+    }
+    
+    // Возвращает фактически зачтенную сумму (не больше остатка по счету)
+    long long applyPayment(const string& billId, long long cents) {
+        shared_lock<shared_mutex> lck(ledgerMutex);
+        return max(applyLocked(billId, cents), 0LL);
+    }
+    
+    // Гасит весь остаток по счету; -1, если счета нет
+    long long settle(const string& billId) {
+        shared_lock<shared_mutex> lck(ledgerMutex);
+        return applyLocked(billId, LLONG_MAX);
+    }
+    
+    // Строки вида "BILL-ID,сумма"; текст делится на части по границам строк
+    RemittanceResult applyRemittance(string_view csv, unsigned threadCount = thread::hardware_concurrency()) {
+        if (threadCount == 0) threadCount = 1;
+        vector<size_t> bounds(1, 0);
+        for (unsigned t = 1; t < threadCount; ++t) {
+            size_t pos = max(bounds.back(), csv.size() * t / threadCount);
+            while (pos > 0 && pos < csv.size() && csv[pos - 1] != '\n') pos++;
+            bounds.push_back(pos);
+        }
+        bounds.push_back(csv.size());
+        
+        shared_lock<shared_mutex> lck(ledgerMutex);
+        vector<RemittanceResult> partial(threadCount);
+        auto work = [&](unsigned t) {
+            RemittanceResult& result = partial[t];
+            string billId;
+            size_t pos = bounds[t];
+            while (pos < bounds[t + 1]) {
+                size_t end = csv.find('\n', pos);
+                if (end == string_view::npos || end > bounds[t + 1]) end = bounds[t + 1];
+                string_view line = csv.substr(pos, end - pos);
+                pos = end + 1;
+                if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+                if (line.empty()) continue;
+                result.lines++;
+                size_t comma = line.find(',');
+                long long cents = comma == string_view::npos ? -1 : parseCents(line.substr(comma + 1));
+                if (cents < 0) {
+                    result.rejected++;
+                    continue;
+                }
+                billId.assign(line.data(), comma);
+                long long applied = applyLocked(billId, cents);
+                if (applied < 0) {
+                    result.rejected++;
+                    continue;
+                }
+                result.appliedCents += applied;
+                result.unappliedCents += cents - applied;
+            }
+        };
+        vector<thread> workers;
+        for (unsigned t = 1; t < threadCount; ++t) {
+            workers.emplace_back(work, t);
+        }
+        work(0);
+        for (auto& w : workers) {
+            w.join();
+        }
+        
+        RemittanceResult total;
+        for (const auto& result : partial) {
+            total.lines += result.lines;
+            total.rejected += result.rejected;
+            total.appliedCents += result.appliedCents;
+            total.unappliedCents += result.unappliedCents;
+        }
+        return total;
+    }
+    
+    long long outstandingForPatient(const string& patientId) const {
+        shared_lock<shared_mutex> lck(ledgerMutex);
+        return getOrZero(patientBalances, patientId);
+    }
+    
+    long long outstandingForDoctor(const string& doctorId) const {
+        shared_lock<shared_mutex> lck(ledgerMutex);
+        return getOrZero(doctorBalances, doctorId);
+    }
+    
+    bool isPaid(const string& billId) const {
+        shared_lock<shared_mutex> lck(ledgerMutex);
+        auto it = billById.find(billId);
+        return it != billById.end() && it->second->outstanding.load() == 0;
+    }
+    
+    long long totalReceivables() const { return receivables.load(); }
+};
+
+void Billing::pay(BillingLedger& ledger) {
+    ledger.add(*this);   // счет, которого еще нет в журнале, сначала заводится
+    ledger.settle(id);
+    isPaid = true;
+}
+
 class MedicalSystem {
 private:
-    vector<Patient> patients;
-    vector<Doctor> doctors;
+    SlotMap<Patient> patients;
+    SlotMap<Doctor> doctors;
+    unordered_map<string, Handle> patientById;
+    unordered_map<string, Handle> doctorById;
+    unordered_map<string, vector<Handle>> doctorsBySpecialization;
     vector<Appointment> appointments;
-    vector<MedicalRecord> records;
-    vector<Prescription> prescriptions;
-    vector<Billing> bills;
+    unordered_map<string, size_t> appointmentIndex; // id -> позиция в appointments
+    mutex appointmentsMutex;
+    atomic<unsigned long> nextAppointmentId{1};
+    MedicalHistory history;
+    atomic<unsigned long> nextRecordId{1};
+    atomic<unsigned long> nextPrescriptionId{1};
+    BillingLedger billing;
+    atomic<unsigned long> nextBillId{1};
 public:
-    void addPatient(Patient patient) {
-        patients.push_back(patient);
+    // Возвращает дескриптор пациента или пустой дескриптор, если такой id уже есть
+    Handle addPatient(Patient patient) {
+        if (patientById.count(patient.getId())) return Handle();
+        Handle h = patients.insert(patient);
+        patientById[patient.getId()] = h;
+        return h;
+    }
+    
+    Handle addDoctor(Doctor doctor) {
+        if (doctorById.count(doctor.getId())) return Handle();
+        Handle h = doctors.insert(doctor);
+        doctorById[doctor.getId()] = h;
+        doctorsBySpecialization[doctor.getSpecialization()].push_back(h);
+        return h;
+    }
+    
+    // Указатели остаются действительными при добавлении новых врачей и пациентов
+    Patient* getPatient(Handle h) { return patients.get(h); }
+    Doctor* getDoctor(Handle h) { return doctors.get(h); }
+    
+    Patient* findPatient(string id) {
+        auto it = patientById.find(id);
+        return it != patientById.end() ? patients.get(it->second) : nullptr;
     }
     
-    void addDoctor(Doctor doctor) {
-        doctors.push_back(doctor);
+    Doctor* findDoctor(string id) {
+        auto it = doctorById.find(id);
+        return it != doctorById.end() ? doctors.get(it->second) : nullptr;
     }
     
+    // Безопасно вызывать из нескольких потоков: слот занимается атомарно под блокировкой
+    // врача, а номер приема выдается атомарным счетчиком
     string bookAppointment(Patient* patient, Doctor* doctor, string dateTime, string reason) {
         if (doctor->bookAppointment(dateTime)) {
-            string id = "APP-" + to_string(appointments.size() + 1);
+            string id = "APP-" + to_string(nextAppointmentId.fetch_add(1));
+            lock_guard<mutex> lck(appointmentsMutex);
+            appointmentIndex[id] = appointments.size();
             appointments.emplace_back(id, patient, doctor, dateTime, reason);
+            history.add(appointments.back());
             return id;
         }
         return "";
     }
     
+    bool cancelAppointment(string id) {
+        lock_guard<mutex> lck(appointmentsMutex);
+        auto it = appointmentIndex.find(id);
+        return it != appointmentIndex.end() && appointments[it->second].cancel();
+    }
+    
+    // Число запланированных приемов и проверка, что ни один слот не занят дважды
+    size_t countScheduled(bool& consistent) {
+        lock_guard<mutex> lck(appointmentsMutex);
+        map<pair<Doctor*, string>, int> taken;
+        size_t scheduled = 0;
+        consistent = true;
+        for (const auto& appt : appointments) {
+            if (appt.getStatus() != "Scheduled") continue;
+            scheduled++;
+            if (++taken[make_pair(appt.getDoctor(), appt.getDateTime())] > 1 ||
+                appt.getDoctor()->isAvailable(appt.getDateTime())) {
+                consistent = false;
+            }
+        }
+        return scheduled;
+    }
+    
     vector<Doctor*> findDoctorsBySpecialization(string specialization) {
         vector<Doctor*> result;
-        for (auto& doc : doctors) {
-            if (doc.getSpecialization() == specialization) {
-                result.push_back(&doc);
+        auto it = doctorsBySpecialization.find(specialization);
+        if (it == doctorsBySpecialization.end()) return result;
+        result.reserve(it->second.size());
+        for (Handle h : it->second) {
+            if (Doctor* doc = doctors.get(h)) {
+                result.push_back(doc);
             }
         }
         return result;
     }
     
-    void createMedicalRecord(Patient* patient, Doctor* doctor, string diagnosis, string treatment) {
-        string id = "MR-" + to_string(records.size() + 1);
-        records.emplace_back(id, patient, doctor, diagnosis, treatment);
+    // Самый ранний свободный слот среди врачей специализации за даты [fromDate, toDate]
+    pair<Doctor*, int> findEarliestSlot(string specialization, string fromDate, string toDate) {
+        int from = parseDay(fromDate) * SLOTS_PER_DAY;
+        int to = (parseDay(toDate) + 1) * SLOTS_PER_DAY;
+        pair<Doctor*, int> best(nullptr, -1);
+        if (from < 0 || to <= from) return best;
+        for (Doctor* doc : findDoctorsBySpecialization(specialization)) {
+            // Дальше уже найденного слота искать не нужно
+            int slot = doc->findFirstFree(from, best.second < 0 ? to : best.second);
+            if (slot >= 0) {
+                best = make_pair(doc, slot);
+            }
+        }
+        return best;
+    }
+    
+    void createMedicalRecord(Patient* patient, Doctor* doctor, string diagnosis, string treatment,
+                             time_t date = time(nullptr)) {
+        string id = "MR-" + to_string(nextRecordId.fetch_add(1));
+        history.add(MedicalRecord(id, patient, doctor, diagnosis, treatment, date));
     }
     
-    void createPrescription(Patient* patient, Doctor* doctor, vector<string> meds, string instructions) {
-        string id = "RX-" + to_string(prescriptions.size() + 1);
-        prescriptions.emplace_back(id, patient, doctor, meds, instructions);
+    void createPrescription(Patient* patient, Doctor* doctor, vector<string> meds, string instructions,
+                            time_t date = time(nullptr)) {
+        string id = "RX-" + to_string(nextPrescriptionId.fetch_add(1));
+        history.add(Prescription(id, patient, doctor, meds, instructions, date));
     }
     
-    void createBill(Patient* patient, double amount, string description) {
-        string id = "BILL-" + to_string(bills.size() + 1);
-        bills.emplace_back(id, patient, amount, description);
+    string createBill(Patient* patient, double amount, string description, Doctor* doctor = nullptr) {
+        string id = "BILL-" + to_string(nextBillId.fetch_add(1));
+        Billing bill(id, patient, amount, description, time(nullptr), doctor);
+        billing.add(bill);
+        history.add(bill);
+        return id;
     }
+    
+    const MedicalHistory& getHistory() const { return history; }
+    BillingLedger& getBilling() { return billing; }
 };
 
-int main() {
+#ifdef __linux__
+// Встроенный HTTP/1.1 сервер на epoll: один поток, неблокирующие сокеты, keep-alive.
+// Отдает поиск врачей, свободные слоты и запись на прием в формате JSON.
+class HttpServer {
+private:
+    struct Connection {
+        string in;
+        string out;
+        size_t outPos = 0;
+        bool closeAfterWrite = false;
+    };
+    
+    static const size_t MAX_REQUEST = 64 * 1024;
+    
+    MedicalSystem& system;
+    uint16_t port;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    atomic<bool> running{false};
+    unordered_map<int, Connection> connections;
+    
+    static string jsonEscape(const string& text) {
+        string result;
+        result.reserve(text.size());
+        for (char c : text) {
+            switch (c) {
+                case '"': result += "\\\""; break;
+                case '\\': result += "\\\\"; break;
+                case '\n': result += "\\n"; break;
+                case '\r': result += "\\r"; break;
+                case '\t': result += "\\t"; break;
+                default:
+                    if ((unsigned char)c < 0x20) {
+                        char buf[8];
+                        snprintf(buf, sizeof(buf), "\\u%04x", c);
+                        result += buf;
+                    } else {
+                        result += c;
+                    }
+            }
+        }
+        return result;
+    }
+    
+    static string urlDecode(string_view text) {
+        string result;
+        result.reserve(text.size());
+        for (size_t i = 0; i < text.size(); ++i) {
+            if (text[i] == '+') {
+                result += ' ';
+            } else if (text[i] == '%' && i + 2 < text.size() && isxdigit((unsigned char)text[i + 1]) &&
+                       isxdigit((unsigned char)text[i + 2])) {
+                result += (char)stoi(string(text.substr(i + 1, 2)), nullptr, 16);
+                i += 2;
+            } else {
+                result += text[i];
+            }
+        }
+        return result;
+    }
+    
+    // "a=1&b=2" -> {a: 1, b: 2}
+    static map<string, string> parseParams(string_view text) {
+        map<string, string> params;
+        while (!text.empty()) {
+            size_t amp = text.find('&');
+            string_view pair = text.substr(0, amp);
+            size_t eq = pair.find('=');
+            if (eq != string_view::npos) {
+                params[urlDecode(pair.substr(0, eq))] = urlDecode(pair.substr(eq + 1));
+            } else if (!pair.empty()) {
+                params[urlDecode(pair)] = "";
+            }
+            if (amp == string_view::npos) break;
+            text.remove_prefix(amp + 1);
+        }
+        return params;
+    }
+    
+    static string doctorJson(const Doctor* doc) {
+        return "{\"id\":\"" + jsonEscape(doc->getId()) + "\",\"name\":\"" + jsonEscape(doc->getName()) +
+               "\",\"specialization\":\"" + jsonEscape(doc->getSpecialization()) + "\"}";
+    }
+    
+    static string error(const string& message) {
+        return "{\"error\":\"" + jsonEscape(message) + "\"}";
+    }
+    
+    // Возвращает код ответа и тело
+    pair<int, string> route(const string& method, const string& path, map<string, string>& params) {
+        if (path == "/doctors" && method == "GET") {
+            string body = "{\"doctors\":[";
+            bool first = true;
+            for (const Doctor* doc : system.findDoctorsBySpecialization(params["specialization"])) {
+                if (!first) body += ',';
+                body += doctorJson(doc);
+                first = false;
+            }
+            return make_pair(200, body + "]}");
+        }
+        if (path == "/slots" && method == "GET") {
+            Doctor* doc = system.findDoctor(params["doctor"]);
+            if (!doc) return make_pair(404, error("unknown doctor"));
+            int from = parseDay(params["from"]);
+            int to = parseDay(params["to"].empty() ? params["from"] : params["to"]);
+            if (from < 0 || to < from) return make_pair(400, error("bad date range"));
+            int limit = params["limit"].empty() ? 20 : atoi(params["limit"].c_str());
+            string body = "{\"doctor\":" + doctorJson(doc) + ",\"slots\":[";
+            int slot = from * SLOTS_PER_DAY;
+            for (int found = 0; found < limit; ++found) {
+                slot = doc->findFirstFree(slot, (to + 1) * SLOTS_PER_DAY);
+                if (slot < 0) break;
+                if (found > 0) body += ',';
+                body += "\"" + formatSlot(slot) + "\"";
+                slot++;
+            }
+            return make_pair(200, body + "]}");
+        }
+        if (path == "/earliest" && method == "GET") {
+            auto earliest = system.findEarliestSlot(params["specialization"], params["from"],
+                                                    params["to"].empty() ? params["from"] : params["to"]);
+            if (!earliest.first) return make_pair(404, error("no free slots"));
+            return make_pair(200, "{\"doctor\":" + doctorJson(earliest.first) + ",\"slot\":\"" +
+                                  formatSlot(earliest.second) + "\"}");
+        }
+        if (path == "/appointments" && method == "POST") {
+            Patient* patient = system.findPatient(params["patient"]);
+            Doctor* doc = system.findDoctor(params["doctor"]);
+            if (!patient || !doc) return make_pair(404, error("unknown patient or doctor"));
+            string id = system.bookAppointment(patient, doc, params["time"], params["reason"]);
+            if (id.empty()) return make_pair(409, error("slot unavailable"));
+            return make_pair(201, "{\"id\":\"" + jsonEscape(id) + "\"}");
+        }
+        return make_pair(404, error("not found"));
+    }
+    
+    static const char* statusText(int code) {
+        switch (code) {
+            case 200: return "OK";
+            case 201: return "Created";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 409: return "Conflict";
+            case 413: return "Payload Too Large";
+            default: return "Error";
+        }
+    }
+    
+    static void appendResponse(Connection& conn, int code, const string& body, bool keepAlive) {
+        conn.out += "HTTP/1.1 " + to_string(code) + " " + statusText(code) +
+                    "\r\nContent-Type: application/json\r\nContent-Length: " + to_string(body.size()) +
+                    (keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n");
+        conn.out += body;
+        if (!keepAlive) conn.closeAfterWrite = true;
+    }
+    
+    // Разбирает все полностью полученные запросы из буфера (поддерживается конвейеризация)
+    void processRequests(Connection& conn) {
+        while (!conn.closeAfterWrite) {
+            size_t headerEnd = conn.in.find("\r\n\r\n");
+            if (headerEnd == string::npos) {
+                if (conn.in.size() > MAX_REQUEST) appendResponse(conn, 413, error("request too large"), false);
+                return;
+            }
+            string_view head(conn.in.data(), headerEnd);
+            size_t lineEnd = head.find("\r\n");
+            string_view requestLine = head.substr(0, lineEnd);
+            size_t sp1 = requestLine.find(' ');
+            size_t sp2 = requestLine.rfind(' ');
+            if (sp1 == string_view::npos || sp2 == sp1) {
+                appendResponse(conn, 400, error("bad request line"), false);
+                return;
+            }
+            string method(requestLine.substr(0, sp1));
+            string_view target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+            bool keepAlive = requestLine.substr(sp2 + 1) == "HTTP/1.1";
+            size_t contentLength = 0;
+            size_t pos = lineEnd == string_view::npos ? head.size() : lineEnd + 2;
+            while (pos < head.size()) {
+                size_t end = head.find("\r\n", pos);
+                if (end == string_view::npos) end = head.size();
+                string_view line = head.substr(pos, end - pos);
+                size_t colon = line.find(':');
+                if (colon != string_view::npos) {
+                    string name(line.substr(0, colon));
+                    transform(name.begin(), name.end(), name.begin(), ::tolower);
+                    string_view value = line.substr(colon + 1);
+                    while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+                    if (name == "content-length") {
+                        contentLength = strtoul(string(value).c_str(), nullptr, 10);
+                    } else if (name == "connection") {
+                        string v(value);
+                        transform(v.begin(), v.end(), v.begin(), ::tolower);
+                        if (v == "close") keepAlive = false;
+                        if (v == "keep-alive") keepAlive = true;
+                    }
+                }
+                pos = end + 2;
+            }
+            if (contentLength > MAX_REQUEST) {
+                appendResponse(conn, 413, error("request too large"), false);
+                return;
+            }
+            size_t total = headerEnd + 4 + contentLength;
+            if (conn.in.size() < total) return; // тело еще не пришло
+            
+            size_t question = target.find('?');
+            string path(target.substr(0, question));
+            map<string, string> params;
+            if (question != string_view::npos) params = parseParams(target.substr(question + 1));
+            for (auto& param : parseParams(string_view(conn.in).substr(headerEnd + 4, contentLength))) {
+                params[param.first] = param.second;
+            }
+            auto response = route(method, path, params);
+            appendResponse(conn, response.first, response.second, keepAlive);
+            conn.in.erase(0, total);
+        }
+    }
+    
+    void closeConnection(int fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections.erase(fd);
+    }
+    
+    // false, если соединение закрыто
+    bool flush(int fd, Connection& conn) {
+        while (conn.outPos < conn.out.size()) {
+            ssize_t n = send(fd, conn.out.data() + conn.outPos, conn.out.size() - conn.outPos, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                closeConnection(fd);
+                return false;
+            }
+            conn.outPos += n;
+        }
+        if (conn.outPos == conn.out.size()) {
+            conn.out.clear();
+            conn.outPos = 0;
+            if (conn.closeAfterWrite) {
+                closeConnection(fd);
+                return false;
+            }
+        }
+        epoll_event ev{};
+        // После закрытия на запись читать больше нечего: ждем только возможности отправить ответ
+        ev.events = (conn.closeAfterWrite ? 0u : (uint32_t)EPOLLIN) | (conn.out.empty() ? 0u : (uint32_t)EPOLLOUT);
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+        return true;
+    }
+    
+    void acceptConnections() {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+            connections[fd];
+        }
+    }
+    
+    void readFrom(int fd) {
+        auto it = connections.find(fd);
+        if (it == connections.end()) return;
+        Connection& conn = it->second;
+        char buf[16 * 1024];
+        bool peerClosed = false;
+        while (true) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n > 0) {
+                conn.in.append(buf, n);
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n < 0) {
+                closeConnection(fd); // ошибка сокета
+                return;
+            }
+            peerClosed = true; // клиент закрыл свою сторону: уже полученные запросы все равно обслуживаем
+            break;
+        }
+        processRequests(conn);
+        if (peerClosed) {
+            conn.closeAfterWrite = true;
+            if (conn.out.empty()) {
+                closeConnection(fd);
+                return;
+            }
+        }
+        flush(fd, conn);
+    }
+public:
+    HttpServer(MedicalSystem& system, uint16_t port) : system(system), port(port) {}
+    
+    ~HttpServer() {
+        for (auto& entry : connections) close(entry.first);
+        if (listenFd >= 0) close(listenFd);
+        if (epollFd >= 0) close(epollFd);
+        if (wakeFd >= 0) close(wakeFd);
+    }
+    
+    // Открывает сокет на 127.0.0.1; при port == 0 порт выбирает система
+    bool start() {
+        listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) return false;
+        int one = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, SOMAXCONN) < 0) return false;
+        socklen_t len = sizeof(addr);
+        getsockname(listenFd, (sockaddr*)&addr, &len);
+        port = ntohs(addr.sin_port);
+        
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || wakeFd < 0) return false;
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = listenFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+        ev.data.fd = wakeFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+        running = true;
+        return true;
+    }
+    
+    void run() {
+        epoll_event events[256];
+        while (running) {
+            int n = epoll_wait(epollFd, events, 256, -1);
+            for (int i = 0; i < n; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    acceptConnections();
+                } else if (fd == wakeFd) {
+                    running = false;
+                } else if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    readFrom(fd);
+                } else if (events[i].events & EPOLLOUT) {
+                    auto it = connections.find(fd);
+                    if (it != connections.end()) flush(fd, it->second);
+                }
+            }
+        }
+    }
+    
+    // Можно вызывать из другого потока
+    void stop() {
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) running = false;
+    }
+    
+    uint16_t getPort() const { return port; }
+};
+
+// Нагрузочный тест в стиле wrk: каждое соединение keep-alive отправляет запрос и ждет ответ
+long long runLoadTest(uint16_t port, const string& request, int connectionCount, double seconds) {
+    atomic<long long> completed{0};
+    atomic<bool> stopFlag{false};
+    vector<thread> clients;
+    for (int c = 0; c < connectionCount; ++c) {
+        clients.emplace_back([&]() {
+            int fd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+                close(fd);
+                return;
+            }
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            string buffer;
+            char buf[16 * 1024];
+            long long local = 0;
+            while (!stopFlag) {
+                if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) < 0) break;
+                // Ждем полный ответ: заголовки и тело длиной Content-Length
+                size_t total = string::npos;
+                while (total == string::npos || buffer.size() < total) {
+                    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+                    if (n <= 0) {
+                        stopFlag = true;
+                        break;
+                    }
+                    buffer.append(buf, n);
+                    size_t headerEnd = buffer.find("\r\n\r\n");
+                    if (total == string::npos && headerEnd != string::npos) {
+                        size_t cl = buffer.find("Content-Length: ");
+                        if (cl == string::npos || cl > headerEnd) {
+                            stopFlag = true; // без длины тела не понять, где кончается ответ
+                            break;
+                        }
+                        total = headerEnd + 4 + strtoul(buffer.c_str() + cl + 16, nullptr, 10);
+                    }
+                }
+                if (total == string::npos || buffer.size() < total) break;
+                buffer.erase(0, total);
+                local++;
+            }
+            completed += local;
+            close(fd);
+        });
+    }
+    this_thread::sleep_for(chrono::duration<double>(seconds));
+    stopFlag = true;
+    for (auto& client : clients) {
+        client.join();
+    }
+    return completed;
+}
+
+// Один запрос по новому соединению, возвращает ответ целиком
+string httpExchange(uint16_t port, const string& request) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    string response;
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0 &&
+        send(fd, request.data(), request.size(), MSG_NOSIGNAL) >= 0) {
+        char buf[4096];
+        ssize_t n;
+        while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+            response.append(buf, n);
+        }
+    }
+    close(fd);
+    return response;
+}
+#endif
+
+int main(int argc, char* argv[]) {
     MedicalSystem system;
     
     // Добавляем пациентов
     Patient p1("P1001", "John Doe", "1980-05-15", "Male", "john@example.com");
     Patient p2("P1002", "Jane Smith", "1990-08-22", "Female", "jane@example.com");
-    system.addPatient(p1);
+    Handle p1Handle = system.addPatient(p1);
     system.addPatient(p2);
     
     // Добавляем врачей
     Doctor d1("D2001", "Dr. Smith", "Cardiology");
     d1.addAvailability("2023-06-01 10:00");
     d1.addAvailability("2023-06-01 11:00");
-    system.addDoctor(d1);
+    Handle d1Handle = system.addDoctor(d1);
     
     Doctor d2("D2002", "Dr. Johnson", "Neurology");
     d2.addAvailability("2023-06-02 09:00");
     system.addDoctor(d2);
     
     // Записываем на прием
-    string apptId = system.bookAppointment(&p1, &d1, "2023-06-01 10:00", "Heart checkup");
+    Doctor* cardiologist = system.getDoctor(d1Handle);
+    string apptId = system.bookAppointment(system.getPatient(p1Handle), cardiologist, "2023-06-01 10:00", "Heart checkup");
     if (!apptId.empty()) {
         cout << "Appointment booked: " << apptId << endl;
     }
@@ -218,5 +1383,185 @@ int main() {
     auto cardiologists = system.findDoctorsBySpecialization("Cardiology");
     cout << "Found " << cardiologists.size() << " cardiologists" << endl;
     
+    // Ищем ближайший свободный прием у кардиологов
+    auto earliest = system.findEarliestSlot("Cardiology", "2023-06-01", "2023-06-30");
+    if (earliest.first) {
+        cout << "Earliest cardiology slot: " << earliest.first->getName() << " at " << formatSlot(earliest.second) << endl;
+    }
+    
+#ifdef __linux__
+    // Веб-интерфейс: "main serve [порт]" запускает сервер, иначе выполняется короткий нагрузочный тест
+    bool serveMode = argc > 1 && string(argv[1]) == "serve";
+    HttpServer server(system, serveMode ? (argc > 2 ? atoi(argv[2]) : 8080) : 0);
+    if (!server.start()) {
+        cerr << "Cannot start HTTP server" << endl;
+    } else if (serveMode) {
+        cout << "Listening on http://127.0.0.1:" << server.getPort()
+             << " (GET /doctors, GET /slots, GET /earliest, POST /appointments)" << endl;
+        server.run();
+        return 0;
+    } else {
+        thread serverThread(&HttpServer::run, &server);
+        string booking = "patient=P1002&doctor=D2001&time=2023-06-01+11%3A00&reason=Follow-up";
+        string response = httpExchange(server.getPort(),
+            "POST /appointments HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n"
+            "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: " + to_string(booking.size()) +
+            "\r\n\r\n" + booking);
+        cout << "HTTP booking: " << response.substr(response.find("\r\n\r\n") + 4) << endl;
+        string request = "GET /doctors?specialization=Cardiology HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        const double seconds = 1.0;
+        long long served = runLoadTest(server.getPort(), request, 4, seconds);
+        cout << "HTTP load test: " << served << " requests in " << seconds << " s over 4 keep-alive connections ("
+             << (long long)(served / seconds) << " req/s)" << endl;
+        server.stop();
+        serverThread.join();
+    }
+#else
+    (void)argc;
+    (void)argv;
+#endif
+    
+    // Ведем историю пациента и читаем ее постранично
+    Patient* john = system.getPatient(p1Handle);
+    system.createMedicalRecord(john, cardiologist, "Arrhythmia", "Beta blockers", parseSlot("2023-06-01 10:00") * SLOT_MINUTES * 60 + 1800);
+    system.createPrescription(john, cardiologist, {"Metoprolol", "Aspirin"}, "Once daily", parseSlot("2023-06-01 10:00") * SLOT_MINUTES * 60 + 1900);
+    string billId = system.createBill(john, 150.0, "Cardiology consultation", cardiologist);
+    const MedicalHistory& history = system.getHistory();
+    HistoryCursor cursor;
+    int pageNumber = 1;
+    while (true) {
+        HistoryPage page = history.page(john->getId(), cursor, 2);
+        for (const auto& entry : page.entries) {
+            cout << "History page " << pageNumber << ": " << history.text(entry.id) << " - " << history.text(entry.text) << endl;
+        }
+        if (!page.hasMore) break;
+        cursor = page.next;
+        pageNumber++;
+    }
+    
+    // Частичная оплата счета и остатки долга
+    BillingLedger& billing = system.getBilling();
+    billing.applyPayment(billId, parseCents("100.00"));
+    cout << "John owes " << formatCents(billing.outstandingForPatient(john->getId())) << ", Dr. Smith receivable "
+         << formatCents(billing.outstandingForDoctor(cardiologist->getId())) << ", total receivables "
+         << formatCents(billing.totalReceivables()) << endl;
+    // Полная оплата счета идет через журнал, поэтому флаг счета и остатки совпадают
+    Billing labTests("BILL-LAB-1", john, 80.0, "Lab tests", time(nullptr), cardiologist);
+    labTests.pay(billing);
+    cout << "Lab tests paid: " << (labTests.paid() && billing.isPaid(labTests.getId()) ? "yes" : "MISMATCH")
+         << ", total receivables " << formatCents(billing.totalReceivables()) << ", 20-digit amount "
+         << (parseCents("12345678901234567890.00") < 0 ? "rejected" : "accepted") << endl;
+    
+    // Ночной реестр оплат от страховой: миллион строк применяется параллельно
+    {
+        BillingLedger bigLedger;
+        deque<Patient> insured;
+        for (int i = 0; i < 10000; ++i) {
+            insured.emplace_back("IP" + to_string(i), "Insured " + to_string(i), "1975-01-01", "Male", "");
+        }
+        for (int i = 0; i < 200000; ++i) {
+            bigLedger.add(Billing("IB-" + to_string(i), &insured[i % insured.size()], 100.0, "Visit", 0, cardiologist));
+        }
+        string remittance;
+        remittance.reserve(20 << 20);
+        mt19937 rng(11);
+        for (int i = 0; i < 1000000; ++i) {
+            remittance += "IB-" + to_string(rng() % 200000) + "," + to_string(5 + rng() % 20) + ".50\n";
+        }
+        long long before = bigLedger.totalReceivables();
+        auto remitStart = chrono::steady_clock::now();
+        auto result = bigLedger.applyRemittance(remittance);
+        double remitMs = chrono::duration<double, milli>(chrono::steady_clock::now() - remitStart).count();
+        bool balanced = before - result.appliedCents == bigLedger.totalReceivables();
+        cout << "Remittance: " << result.lines << " lines in " << remitMs << " ms, applied "
+             << formatCents(result.appliedCents) << ", overpaid " << formatCents(result.unappliedCents) << ", rejected "
+             << result.rejected << ", receivables " << formatCents(bigLedger.totalReceivables())
+             << (balanced ? " (balanced)" : " (MISMATCH)") << endl;
+    }
+    
+    // Нагрузочная проверка: миллион записей у ста тысяч пациентов, каждая десятая - задним числом
+    {
+        MedicalHistory bigHistory;
+        deque<Patient> bigPatients;
+        for (int i = 0; i < 100000; ++i) {
+            bigPatients.emplace_back("BP" + to_string(i), "Patient " + to_string(i), "1980-01-01", "Female", "");
+        }
+        mt19937 rng(7);
+        time_t base = parseDay("2020-01-01") * 86400LL;
+        auto fillStart = chrono::steady_clock::now();
+        for (int i = 0; i < 1000000; ++i) {
+            Patient* patient = &bigPatients[rng() % bigPatients.size()];
+            time_t when = base + i * 60LL - (i % 10 == 0 ? 30 * 86400LL : 0);
+            bigHistory.add(MedicalRecord("MR-B" + to_string(i), patient, cardiologist, "Routine checkup",
+                                         "No treatment required", when));
+        }
+        double fillMs = chrono::duration<double, milli>(chrono::steady_clock::now() - fillStart).count();
+        auto queryStart = chrono::steady_clock::now();
+        size_t found = 0, unordered = 0;
+        for (int i = 0; i < 100000; ++i) {
+            const string& id = bigPatients[rng() % bigPatients.size()].getId();
+            vector<HistoryEntry> window = bigHistory.range(id, base + 200000 * 60LL, base + 400000 * 60LL);
+            found += window.size();
+            found += bigHistory.page(id, HistoryCursor(), 5).entries.size();
+            for (size_t k = 1; k < window.size(); ++k) {
+                unordered += window[k].timestamp < window[k - 1].timestamp;
+            }
+        }
+        double queryUs = chrono::duration<double, micro>(chrono::steady_clock::now() - queryStart).count() / 200000;
+        cout << "History: " << bigHistory.size() << " records (" << bigHistory.textBytes() / (1 << 20) << " MB text) in "
+             << fillMs << " ms, " << queryUs << " us per range/page query (" << found << " entries returned, "
+             << unordered << " out of order)" << endl;
+    }
+    
+    // Бенчмарк: несколько регистратур одновременно записывают к популярным врачам
+    for (int i = 0; i < 4; ++i) {
+        Doctor popular("D3" + to_string(i), "Dr. Popular " + to_string(i), "Therapy");
+        for (int day = 0; day < 20; ++day) {
+            for (int slot = 0; slot < 32; ++slot) {
+                popular.addAvailability(parseDay("2023-07-01") * SLOTS_PER_DAY + day * SLOTS_PER_DAY + 36 + slot);
+            }
+        }
+        system.addDoctor(popular);
+    }
+    vector<Doctor*> therapists = system.findDoctorsBySpecialization("Therapy");
+    Patient* patient = system.findPatient("P1002");
+    const int desks = 8;
+    const int attemptsPerDesk = 50000;
+    atomic<long> booked{0}, cancelled{0};
+    auto benchStart = chrono::steady_clock::now();
+    vector<thread> frontDesks;
+    for (int desk = 0; desk < desks; ++desk) {
+        frontDesks.emplace_back([&, desk]() {
+            mt19937 rng(desk);
+            vector<string> mine;
+            for (int i = 0; i < attemptsPerDesk; ++i) {
+                Doctor* doc = therapists[rng() % therapists.size()];
+                int slot = parseDay("2023-07-01") * SLOTS_PER_DAY + (rng() % 20) * SLOTS_PER_DAY + 36 + rng() % 32;
+                string id = system.bookAppointment(patient, doc, formatSlot(slot), "Checkup");
+                if (!id.empty()) {
+                    booked++;
+                    mine.push_back(id);
+                }
+                if (!mine.empty() && rng() % 4 == 0) {
+                    if (system.cancelAppointment(mine.back())) cancelled++;
+                    mine.pop_back();
+                }
+            }
+        });
+    }
+    for (auto& desk : frontDesks) {
+        desk.join();
+    }
+    double benchSec = chrono::duration<double>(chrono::steady_clock::now() - benchStart).count();
+    cout << "Cardiologist pointer after growth: "
+         << (system.getDoctor(d1Handle) == cardiologist && system.findDoctor("D2001") == cardiologist ? "stable" : "moved") << endl;
+    
+    bool consistent = false;
+    size_t scheduled = system.countScheduled(consistent);
+    cout << "Booking benchmark: " << desks * attemptsPerDesk << " attempts from " << desks << " desks in "
+         << benchSec * 1000 << " ms (" << (long)(desks * attemptsPerDesk / benchSec) << " attempts/sec), "
+         << booked << " booked, " << cancelled << " cancelled, " << scheduled << " scheduled, "
+         << (consistent ? "no double bookings" : "DOUBLE BOOKING DETECTED") << endl;
+    
     return 0;
 }
\ No newline at end of file
@@ -2,6 +2,34 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <ctime>
+#include <deque>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <cstdlib>
+#include <fstream>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <random>
+#include <shared_mutex>
+#include <limits>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -14,6 +42,7 @@ public:
     User(string id, string name, string email) : id(id), name(name), email(email) {}
     string getId() const { return id; }
     string getName() const { return name; }
+    string getEmail() const { return email; }
 };
 
 class Task {
@@ -31,6 +60,7 @@ public:
     void assignTo(User* user) { assignee = user; }
     void logHours(int hours) { actualHours += hours; }
  string getId() const { return id; }
+    User* getAssignee() const { return assignee; }
     int getActualHours() const { return actualHours; }
 };
 
@@ -44,15 +74,434 @@ public:
     ExternalAPI(string name, string endpoint) : name(name), endpoint(endpoint) {}
     
     // Добавлен метод getName()
-    string getName() const { return name; }
+    const string& getName() const { return name; }
+    const string& getEndpoint() const { return endpoint; }
     
     void setConfig(string key, string value) { config[key] = value; }
+    string getConfig(const string& key) const {
+        auto it = config.find(key);
+        return it != config.end() ? it->second : "";
+    }
     string getData(string query) const {
         // В реальной системе здесь было бы HTTP-соединение
         return "Mock data for query: " + query;
     }
 };
 
+// Асинхронный клиент внешнего API. Настройки берутся из ExternalAPI::config:
+//   max_connections - число одновременных запросов и размер пула соединений (4)
+//   cache_ttl_ms    - время жизни ответа в кэше (30000, 0 - без кэша)
+//   timeout_ms      - таймаут чтения/записи сокета (5000)
+//   api_key         - передается в заголовке Authorization
+//   offline_mock    - "1": эндпоинт не http:// (TLS не поддерживается) обслуживается заглушкой
+//                     ExternalAPI::getData, о чем пишется в лог; без этого такой эндпоинт - ошибка запроса
+// Одинаковые запросы, уже отправленные в сеть, не дублируются: вызывающие получают общий future.
+class AsyncApiClient {
+private:
+    struct CacheEntry {
+        string body;
+        chrono::steady_clock::time_point expires;
+    };
+    
+    const ExternalAPI& api;
+    string host;
+    string basePath;
+    int port = 80;
+    bool useNetwork = false;
+    bool useMock = false;
+    int maxConnections;
+    chrono::milliseconds cacheTtl;
+    int timeoutMs;
+    
+    mutex mtx;
+    condition_variable queueReady;
+    deque<pair<string, shared_ptr<promise<string>>>> jobs;
+    unordered_map<string, shared_future<string>> inFlight;
+    unordered_map<string, CacheEntry> cache;
+    size_t sweepAt = 64;          // размер кэша, при котором вычищаются просроченные записи
+    vector<int> idleConnections;
+    vector<thread> workers;
+    bool stopping = false;
+    
+    atomic<long> cacheHits{0};
+    atomic<long> coalesced{0};
+    atomic<long> networkRequests{0};
+    atomic<long> connectionsOpened{0};
+    
+    static string urlEncode(const string& text) {
+        static const char* hex = "0123456789ABCDEF";
+        string result;
+        for (unsigned char c : text) {
+            if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+                result += (char)c;
+            } else {
+                result += '%';
+                result += hex[c >> 4];
+                result += hex[c & 15];
+            }
+        }
+        return result;
+    }
+    
+#ifndef _WIN32
+    int openConnection() {
+        addrinfo hints{}, *res = nullptr;
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &res) != 0) return -1;
+        int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) < 0) {
+            close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(res);
+        if (fd < 0) return -1;
+        timeval tv{timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        connectionsOpened++;
+        return fd;
+    }
+    
+    // Значение заголовка в нижнем регистре, имя сравнивается без учета регистра; пусто, если заголовка нет
+    static string headerValue(const string& head, const string& name) {
+        size_t pos = head.find("\r\n");   // стартовая строка пропускается
+        while (pos != string::npos) {
+            pos += 2;
+            size_t end = min(head.find("\r\n", pos), head.size());
+            size_t colon = head.find(':', pos);
+            if (colon < end && colon - pos == name.size() &&
+                equal(name.begin(), name.end(), head.begin() + pos,
+                      [](char a, char b) { return tolower((unsigned char)a) == tolower((unsigned char)b); })) {
+                size_t first = head.find_first_not_of(" \t", colon + 1);
+                string value = first < end ? head.substr(first, end - first) : string();
+                while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.pop_back();
+                for (char& c : value) c = (char)tolower((unsigned char)c);
+                return value;
+            }
+            pos = end < head.size() ? end : string::npos;
+        }
+        return string();
+    }
+    
+    // Один запрос по соединению keep-alive; false - соединение непригодно.
+    // Тело ответа - по Content-Length или по частям (Transfer-Encoding: chunked)
+    bool exchange(int fd, const string& query, string& body, bool& keepAlive) {
+        string request = "GET " + basePath + "?query=" + urlEncode(query) + " HTTP/1.1\r\nHost: " + host +
+                         "\r\nConnection: keep-alive\r\n";
+        auto key = api.getConfig("api_key");
+        if (!key.empty()) request += "Authorization: Bearer " + key + "\r\n";
+        request += "\r\n";
+        if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t)request.size()) return false;
+        
+        string buffer;
+        char buf[8192];
+        auto receive = [&]() {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) return false;
+            buffer.append(buf, n);
+            return true;
+        };
+        size_t headerEnd;
+        while ((headerEnd = buffer.find("\r\n\r\n")) == string::npos) {
+            if (!receive()) return false;
+        }
+        string head = buffer.substr(0, headerEnd);
+        keepAlive = headerValue(head, "connection") != "close";
+        size_t pos = headerEnd + 4;
+        body.clear();
+        if (headerValue(head, "transfer-encoding").find("chunked") != string::npos) {
+            // Части "размер в hex\r\nданные\r\n", последняя - нулевого размера, затем trailer до пустой строки
+            while (true) {
+                size_t lineEnd;
+                while ((lineEnd = buffer.find("\r\n", pos)) == string::npos) {
+                    if (!receive()) return false;
+                }
+                char* digitsEnd;
+                unsigned long size = strtoul(buffer.c_str() + pos, &digitsEnd, 16);
+                if (digitsEnd == buffer.c_str() + pos) return false;
+                pos = lineEnd + 2;
+                if (size == 0) break;
+                while (buffer.size() < pos + size + 2) {
+                    if (!receive()) return false;
+                }
+                body.append(buffer, pos, size);
+                pos += size + 2;
+            }
+            while (true) {
+                size_t lineEnd = buffer.find("\r\n", pos);
+                if (lineEnd == string::npos) {
+                    if (!receive()) return false;
+                    continue;
+                }
+                bool last = lineEnd == pos;
+                pos = lineEnd + 2;
+                if (last) break;
+            }
+        } else {
+            // Без длины тело нельзя отделить от следующего ответа в том же соединении
+            string length = headerValue(head, "content-length");
+            if (length.empty()) return false;
+            size_t total = pos + strtoul(length.c_str(), nullptr, 10);
+            while (buffer.size() < total) {
+                if (!receive()) return false;
+            }
+            body = buffer.substr(pos, total - pos);
+        }
+        return head.compare(0, 12, "HTTP/1.1 200") == 0;
+    }
+#endif
+    
+    string fetch(const string& query) {
+        if (useMock) return api.getData(query);
+        if (!useNetwork) throw runtime_error("unsupported endpoint " + api.getEndpoint() + " (only http:// is supported)");
+#ifndef _WIN32
+        // Соединение из пула могло быть закрыто сервером, поэтому одна повторная попытка
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            int fd = -1;
+            {
+                lock_guard<mutex> lck(mtx);
+                if (!idleConnections.empty()) {
+                    fd = idleConnections.back();
+                    idleConnections.pop_back();
+                }
+            }
+            if (fd < 0) fd = openConnection();
+            if (fd < 0) throw runtime_error("cannot connect to " + api.getEndpoint());
+            string body;
+            bool keepAlive = false;
+            networkRequests++;
+            if (exchange(fd, query, body, keepAlive)) {
+                if (keepAlive) {
+                    lock_guard<mutex> lck(mtx);
+                    idleConnections.push_back(fd);
+                } else {
+                    close(fd);
+                }
+                return body;
+            }
+            close(fd);
+        }
+        throw runtime_error("request to " + api.getEndpoint() + " failed");
+#else
+        return api.getData(query);
+#endif
+    }
+    
+    void workerLoop() {
+        while (true) {
+            pair<string, shared_ptr<promise<string>>> job;
+            {
+                unique_lock<mutex> lck(mtx);
+                queueReady.wait(lck, [this]() { return stopping || !jobs.empty(); });
+                if (jobs.empty()) return;
+                job = move(jobs.front());
+                jobs.pop_front();
+            }
+            try {
+                string body = fetch(job.first);
+                {
+                    lock_guard<mutex> lck(mtx);
+                    if (cacheTtl.count() > 0) {
+                        auto now = chrono::steady_clock::now();
+                        // Чистка при удвоении кэша: в среднем O(1) на вставку, кэш не растет без границ
+                        if (cache.size() >= sweepAt) {
+                            for (auto it = cache.begin(); it != cache.end();) {
+                                if (it->second.expires <= now) it = cache.erase(it);
+                                else ++it;
+                            }
+                            sweepAt = max<size_t>(64, cache.size() * 2);
+                        }
+                        cache[job.first] = CacheEntry{body, now + cacheTtl};
+                    }
+                    inFlight.erase(job.first);
+                }
+                job.second->set_value(body);
+            } catch (...) {
+                {
+                    lock_guard<mutex> lck(mtx);
+                    inFlight.erase(job.first);
+                }
+                job.second->set_exception(current_exception());
+            }
+        }
+    }
+    
+    static int configInt(const ExternalAPI& api, const string& key, int fallback) {
+        string value = api.getConfig(key);
+        return value.empty() ? fallback : atoi(value.c_str());
+    }
+public:
+    AsyncApiClient(const ExternalAPI& api)
+        : api(api),
+          maxConnections(max(1, configInt(api, "max_connections", 4))),
+          cacheTtl(configInt(api, "cache_ttl_ms", 30000)),
+          timeoutMs(configInt(api, "timeout_ms", 5000)) {
+        // Поддерживается только http://хост[:порт][/путь]; остальное - заглушка по offline_mock или ошибка
+        const string& endpoint = api.getEndpoint();
+        if (endpoint.compare(0, 7, "http://") == 0) {
+            string rest = endpoint.substr(7);
+            size_t slash = rest.find('/');
+            basePath = slash == string::npos ? "/" : rest.substr(slash);
+            string authority = rest.substr(0, slash);
+            size_t colon = authority.find(':');
+            host = authority.substr(0, colon);
+            if (colon != string::npos) port = atoi(authority.c_str() + colon + 1);
+            useNetwork = true;
+        } else if (api.getConfig("offline_mock") == "1") {
+            useMock = true;
+            cerr << "AsyncApiClient: " << api.getName() << " (" << endpoint
+                 << ") is not plain http, answering from ExternalAPI::getData mock" << endl;
+        }
+        for (int i = 0; i < maxConnections; ++i) {
+            workers.emplace_back(&AsyncApiClient::workerLoop, this);
+        }
+    }
+    
+    ~AsyncApiClient() {
+        {
+            lock_guard<mutex> lck(mtx);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        for (auto& w : workers) {
+            w.join();
+        }
+#ifndef _WIN32
+        for (int fd : idleConnections) close(fd);
+#endif
+    }
+    
+    shared_future<string> getAsync(const string& query) {
+        lock_guard<mutex> lck(mtx);
+        auto cached = cache.find(query);
+        if (cached != cache.end()) {
+            if (cached->second.expires > chrono::steady_clock::now()) {
+                cacheHits++;
+                promise<string> ready;
+                ready.set_value(cached->second.body);
+                return ready.get_future().share();
+            }
+            cache.erase(cached);
+        }
+        auto pending = inFlight.find(query);
+        if (pending != inFlight.end()) {
+            coalesced++;
+            return pending->second;
+        }
+        auto result = make_shared<promise<string>>();
+        shared_future<string> future = result->get_future().share();
+        inFlight[query] = future;
+        jobs.emplace_back(query, result);
+        queueReady.notify_one();
+        return future;
+    }
+    
+    string get(const string& query) {
+        return getAsync(query).get();
+    }
+    
+    long getCacheHits() const { return cacheHits; }
+    long getCoalesced() const { return coalesced; }
+    long getNetworkRequests() const { return networkRequests; }
+    long getConnectionsOpened() const { return connectionsOpened; }
+};
+
+#ifndef _WIN32
+// Локальная заглушка внешнего API для проверки клиента: отвечает JSON с задержкой latencyMs.
+// Каждое соединение обслуживается отдельным потоком, keep-alive поддерживается.
+class StubApiServer {
+private:
+    int listenFd = -1;
+    int port = 0;
+    int latencyMs;
+    atomic<bool> running{true};
+    atomic<long> served{0};
+    thread acceptThread;
+    mutex mtx;
+    vector<thread> handlers;
+    vector<int> clientFds;
+    
+    void handle(int fd) {
+        string buffer;
+        char buf[4096];
+        while (running) {
+            size_t headerEnd;
+            while ((headerEnd = buffer.find("\r\n\r\n")) == string::npos) {
+                ssize_t n = recv(fd, buf, sizeof(buf), 0);
+                if (n <= 0) return;
+                buffer.append(buf, n);
+            }
+            string requestLine = buffer.substr(0, buffer.find("\r\n"));
+            buffer.erase(0, headerEnd + 4);
+            size_t q = requestLine.find("query=");
+            string query = q == string::npos ? "" : requestLine.substr(q + 6, requestLine.find(' ', q) - q - 6);
+            this_thread::sleep_for(chrono::milliseconds(latencyMs));
+            string body = "{\"query\":\"" + query + "\",\"hours\":" + to_string(query.size() * 3 % 17) + "}";
+            string response;
+            if (served % 2 == 0) {
+                response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                           to_string(body.size()) + "\r\nConnection: keep-alive\r\n\r\n" + body;
+            } else {
+                // Каждый второй ответ - по частям и с именами заголовков в нижнем регистре
+                char sizes[2][24];
+                size_t half = body.size() / 2;
+                snprintf(sizes[0], sizeof(sizes[0]), "%zx", half);
+                snprintf(sizes[1], sizeof(sizes[1]), "%zx", body.size() - half);
+                response = "HTTP/1.1 200 OK\r\ncontent-type: application/json\r\ntransfer-encoding: chunked\r\n"
+                           "connection: keep-alive\r\n\r\n" + string(sizes[0]) + "\r\n" + body.substr(0, half) +
+                           "\r\n" + string(sizes[1]) + "\r\n" + body.substr(half) + "\r\n0\r\n\r\n";
+            }
+            if (send(fd, response.data(), response.size(), MSG_NOSIGNAL) < 0) return;
+            served++;
+        }
+    }
+public:
+    StubApiServer(int latencyMs) : latencyMs(latencyMs) {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listenFd, (sockaddr*)&addr, sizeof(addr));
+        listen(listenFd, SOMAXCONN);
+        socklen_t len = sizeof(addr);
+        getsockname(listenFd, (sockaddr*)&addr, &len);
+        port = ntohs(addr.sin_port);
+        acceptThread = thread([this]() {
+            while (running) {
+                int fd = accept(listenFd, nullptr, nullptr);
+                if (fd < 0) continue;
+                lock_guard<mutex> lck(mtx);
+                if (!running) {
+                    close(fd);
+                    break;
+                }
+                clientFds.push_back(fd);
+                handlers.emplace_back(&StubApiServer::handle, this, fd);
+            }
+        });
+    }
+    
+    ~StubApiServer() {
+        running = false;
+        shutdown(listenFd, SHUT_RDWR);
+        close(listenFd);
+        acceptThread.join();
+        lock_guard<mutex> lck(mtx);
+        for (int fd : clientFds) shutdown(fd, SHUT_RDWR);
+        for (auto& h : handlers) h.join();
+        for (int fd : clientFds) close(fd);
+    }
+    
+    string getEndpoint() const { return "http://127.0.0.1:" + to_string(port) + "/api/search"; }
+    long getServed() const { return served; }
+};
+#endif
+
 class Notification {
 private:
     string type;
@@ -69,6 +518,365 @@ public:
         // В реальной системе здесь была бы отправка email/SMS и т.д.
         cout << "Notification to " << recipient->getName() << ": " << message << endl;
     }
+    
+    string getType() const { return type; }
+    string getMessage() const { return message; }
+    User* getRecipient() const { return recipient; }
+    time_t getTimestamp() const { return timestamp; }
+};
+
+// Получатель пакета уведомлений. deliver возвращает false при временной ошибке,
+// тогда диспетчер повторит доставку позже.
+class NotificationSink {
+public:
+    virtual ~NotificationSink() {}
+    virtual bool deliver(const User& recipient, const vector<Notification>& digest) = 0;
+};
+
+string formatDigest(const User& recipient, const vector<Notification>& digest) {
+    string text = "Digest for " + recipient.getName() + " (" + to_string(digest.size()) + " notifications)\n";
+    for (const auto& n : digest) {
+        text += "  [" + n.getType() + "] " + n.getMessage() + "\n";
+    }
+    return text;
+}
+
+class StdoutSink : public NotificationSink {
+public:
+    bool deliver(const User& recipient, const vector<Notification>& digest) override {
+        cout << formatDigest(recipient, digest);
+        return true;
+    }
+};
+
+class FileSink : public NotificationSink {
+private:
+    ofstream out;
+public:
+    FileSink(const string& path) : out(path, ios::app) {}
+    
+    bool deliver(const User& recipient, const vector<Notification>& digest) override {
+        if (!out) return false;
+        out << formatDigest(recipient, digest);
+        out.flush();
+        return (bool)out;
+    }
+};
+
+#ifndef _WIN32
+// Отправка дайджеста письмом через SMTP-сервер (например, локальную заглушку)
+class SmtpSink : public NotificationSink {
+private:
+    string host;
+    int port;
+    string from;
+    
+    static bool expect(int fd, const char* code) {
+        char buf[512];
+        string reply;
+        while (reply.find("\r\n") == string::npos) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) return false;
+            reply.append(buf, n);
+        }
+        return reply.compare(0, 3, code) == 0;
+    }
+    
+    static bool command(int fd, const string& line, const char* code) {
+        string data = line + "\r\n";
+        return ::send(fd, data.data(), data.size(), MSG_NOSIGNAL) == (ssize_t)data.size() && expect(fd, code);
+    }
+public:
+    SmtpSink(const string& host, int port, const string& from) : host(host), port(port), from(from) {}
+    
+    bool deliver(const User& recipient, const vector<Notification>& digest) override {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+        timeval tv{5, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        // Точки в начале строк удваиваются, чтобы не завершить DATA раньше времени
+        string body = formatDigest(recipient, digest);
+        string escaped;
+        bool lineStart = true;
+        for (char c : body) {
+            if (lineStart && c == '.') escaped += '.';
+            if (c == '\n') escaped += '\r';
+            escaped += c;
+            lineStart = c == '\n';
+        }
+        bool ok = connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0 && expect(fd, "220") &&
+                  command(fd, "HELO localhost", "250") &&
+                  command(fd, "MAIL FROM:<" + from + ">", "250") &&
+                  command(fd, "RCPT TO:<" + recipient.getEmail() + ">", "250") &&
+                  command(fd, "DATA", "354") &&
+                  command(fd, "Subject: Project notifications\r\n\r\n" + escaped + ".", "250");
+        if (ok) command(fd, "QUIT", "221");
+        close(fd);
+        return ok;
+    }
+};
+
+// Локальная заглушка SMTP: первые failFirst писем отклоняет временной ошибкой 451
+class SmtpStubServer {
+private:
+    int listenFd = -1;
+    int port = 0;
+    atomic<int> failuresLeft;
+    atomic<long> accepted{0};
+    atomic<bool> running{true};
+    thread serverThread;
+    
+    static bool readLine(int fd, string& buffer, string& line) {
+        char buf[1024];
+        size_t end;
+        while ((end = buffer.find("\r\n")) == string::npos) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) return false;
+            buffer.append(buf, n);
+        }
+        line = buffer.substr(0, end);
+        buffer.erase(0, end + 2);
+        return true;
+    }
+    
+    static void reply(int fd, const string& text) {
+        string data = text + "\r\n";
+        ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    }
+    
+    void session(int fd) {
+        string buffer, line;
+        reply(fd, "220 stub ESMTP");
+        while (readLine(fd, buffer, line)) {
+            if (line == "DATA") {
+                reply(fd, "354 end with .");
+                while (readLine(fd, buffer, line) && line != ".") {}
+                if (failuresLeft.fetch_sub(1) > 0) {
+                    reply(fd, "451 try again later");
+                } else {
+                    accepted++;
+                    reply(fd, "250 queued");
+                }
+            } else if (line == "QUIT") {
+                reply(fd, "221 bye");
+                break;
+            } else {
+                reply(fd, "250 ok");
+            }
+        }
+    }
+public:
+    SmtpStubServer(int failFirst) : failuresLeft(failFirst) {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listenFd, (sockaddr*)&addr, sizeof(addr));
+        listen(listenFd, SOMAXCONN);
+        socklen_t len = sizeof(addr);
+        getsockname(listenFd, (sockaddr*)&addr, &len);
+        port = ntohs(addr.sin_port);
+        // Сессии обрабатываются по одной: диспетчер отправляет письма последовательно
+        serverThread = thread([this]() {
+            while (running) {
+                int fd = accept(listenFd, nullptr, nullptr);
+                if (fd < 0) continue;
+                session(fd);
+                close(fd);
+            }
+        });
+    }
+    
+    ~SmtpStubServer() {
+        running = false;
+        shutdown(listenFd, SHUT_RDWR);
+        close(listenFd);
+        serverThread.join();
+    }
+    
+    int getPort() const { return port; }
+    long getAccepted() const { return accepted; }
+};
+#endif
+
+// Фоновый диспетчер уведомлений. Очередь ограничена: post блокируется, пока не освободится место.
+// Уведомления одного получателя собираются в дайджест в течение окна window и отправляются в sink
+// одним пакетом; при ошибке доставка повторяется с экспоненциальной задержкой.
+class NotificationDispatcher {
+public:
+    struct Metrics {
+        size_t queueDepth = 0;
+        size_t maxQueueDepth = 0;
+        long notifications = 0;     // доставлено уведомлений
+        long batches = 0;
+        long retries = 0;
+        long dropped = 0;           // уведомления из дайджестов, исчерпавших попытки
+        double averageBatchSize = 0;
+        double averageLatencyMs = 0;
+        double maxLatencyMs = 0;
+    };
+private:
+    typedef chrono::steady_clock Clock;
+    
+    struct Queued {
+        Notification notification;
+        Clock::time_point enqueued;
+    };
+    
+    struct Digest {
+        User* recipient = nullptr;
+        vector<Notification> items;
+        vector<Clock::time_point> enqueued;
+        Clock::time_point due;
+        int attempts = 0;
+    };
+    
+    NotificationSink& sink;
+    size_t capacity;
+    chrono::milliseconds window;
+    int maxAttempts;
+    chrono::milliseconds backoff;
+    
+    mutable mutex mtx;
+    condition_variable notEmpty;
+    condition_variable notFull;
+    deque<Queued> queue;
+    bool stopping = false;
+    thread worker;
+    
+    Metrics metrics;
+    double totalLatencyMs = 0;
+    
+    void deliver(Digest& digest) {
+        bool ok = sink.deliver(*digest.recipient, digest.items);
+        auto now = Clock::now();
+        lock_guard<mutex> lck(mtx);
+        if (ok) {
+            metrics.batches++;
+            metrics.notifications += digest.items.size();
+            for (auto t : digest.enqueued) {
+                double ms = chrono::duration<double, milli>(now - t).count();
+                totalLatencyMs += ms;
+                metrics.maxLatencyMs = max(metrics.maxLatencyMs, ms);
+            }
+            digest.items.clear();
+        } else if (++digest.attempts >= maxAttempts) {
+            metrics.dropped += digest.items.size();
+            digest.items.clear();
+        } else {
+            metrics.retries++;
+            digest.due = now + backoff * (1 << (digest.attempts - 1));
+        }
+    }
+    
+    void run() {
+        map<string, Digest> pending; // id получателя -> накапливаемый дайджест
+        bool stopSeen = false;
+        while (true) {
+            vector<Queued> batch;
+            bool finishing;
+            {
+                unique_lock<mutex> lck(mtx);
+                auto next = Clock::time_point::max();
+                for (const auto& entry : pending) {
+                    next = min(next, entry.second.due);
+                }
+                notEmpty.wait_until(lck, next, [&]() { return (stopping && !stopSeen) || !queue.empty(); });
+                batch.assign(make_move_iterator(queue.begin()), make_move_iterator(queue.end()));
+                queue.clear();
+                finishing = stopping;
+            }
+            notFull.notify_all();
+            
+            for (auto& item : batch) {
+                User* recipient = item.notification.getRecipient();
+                Digest& digest = pending[recipient->getId()];
+                if (digest.items.empty()) {
+                    digest.recipient = recipient;
+                    digest.due = item.enqueued + window;
+                    digest.attempts = 0;
+                    digest.enqueued.clear();
+                }
+                digest.items.push_back(move(item.notification));
+                digest.enqueued.push_back(item.enqueued);
+            }
+            
+            auto now = Clock::now();
+            for (auto it = pending.begin(); it != pending.end();) {
+                // При остановке оставшиеся дайджесты отправляются без ожидания окна, но с повторами
+                if (it->second.due <= now || (finishing && it->second.attempts == 0)) {
+                    deliver(it->second);
+                }
+                if (it->second.items.empty()) {
+                    it = pending.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if (finishing && pending.empty()) {
+                lock_guard<mutex> lck(mtx);
+                if (queue.empty()) return;
+            }
+            stopSeen = finishing;
+        }
+    }
+public:
+    NotificationDispatcher(NotificationSink& sink, size_t capacity = 10000,
+                           chrono::milliseconds window = chrono::milliseconds(200),
+                           int maxAttempts = 5, chrono::milliseconds backoff = chrono::milliseconds(50))
+        : sink(sink), capacity(max<size_t>(1, capacity)), window(window), maxAttempts(maxAttempts),
+          backoff(backoff) {
+        worker = thread(&NotificationDispatcher::run, this);
+    }
+    
+    ~NotificationDispatcher() {
+        stop();
+    }
+    
+    void post(const Notification& notification) {
+        unique_lock<mutex> lck(mtx);
+        notFull.wait(lck, [this]() { return stopping || queue.size() < capacity; });
+        if (stopping) return;
+        queue.push_back(Queued{notification, Clock::now()});
+        metrics.maxQueueDepth = max(metrics.maxQueueDepth, queue.size());
+        notEmpty.notify_one();
+    }
+    
+    // Не ждет места в очереди; false, если очередь заполнена
+    bool tryPost(const Notification& notification) {
+        lock_guard<mutex> lck(mtx);
+        if (stopping || queue.size() >= capacity) return false;
+        queue.push_back(Queued{notification, Clock::now()});
+        metrics.maxQueueDepth = max(metrics.maxQueueDepth, queue.size());
+        notEmpty.notify_one();
+        return true;
+    }
+    
+    // Отправляет все накопленное и останавливает фоновый поток
+    void stop() {
+        {
+            lock_guard<mutex> lck(mtx);
+            if (stopping) return;
+            stopping = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+        worker.join();
+    }
+    
+    Metrics getMetrics() const {
+        lock_guard<mutex> lck(mtx);
+        Metrics result = metrics;
+        result.queueDepth = queue.size();
+        result.averageBatchSize = metrics.batches ? (double)metrics.notifications / metrics.batches : 0;
+        result.averageLatencyMs = metrics.notifications ? totalLatencyMs / metrics.notifications : 0;
+        return result;
+    }
 };
 
 class Report {
@@ -81,10 +889,447 @@ public:
     
     void addData(string key, string value) { data[key] = value; }
     void generate() const {
-        cout << "Report: " << title << endl;
+        string out = "Report: " + title + "\n";
         for (const auto& item : data) {
-            cout << item.first << ": " << item.second << endl;
+            out += item.first + ": " + item.second + "\n";
         }
+        cout << out << flush;
+    }
+};
+
+// Номер дня с 1970-01-01 -> год, месяц, день (алгоритм civil_from_days)
+void civilFromDays(long long z, int& y, int& m, int& d) {
+    z += 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    long long doe = z - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    y = (int)(yoe + era * 400 + (m <= 2));
+}
+
+// Табличный отчет с типизированными колонками. Значения хранятся по колонкам без строк:
+// текст кодируется номером в словаре, числа и даты - как есть. Группировка суммирует
+// числовые колонки, сериализация в CSV/JSON пишет прямо в общий буфер.
+class ReportBuilder {
+public:
+    enum ColumnType { Text, Integer, Decimal, Date };
+    
+    // Decimal хранится в сотых долях, поэтому суммы точные
+    struct Cell {
+        ColumnType type;
+        long long value;     // число, сотые доли, номер дня или код текста
+        
+        static Cell text(uint32_t code) { return Cell{Text, code}; }
+        static Cell number(long long value) { return Cell{Integer, value}; }
+        static Cell decimalValue(double value) { return Cell{Decimal, llround(value * 100)}; }
+        static Cell date(long long day) { return Cell{Date, day}; }
+    };
+private:
+    struct Column {
+        string name;
+        ColumnType type;
+        vector<long long> values;
+    };
+    
+    vector<Column> columns;
+    vector<string> dictionary;
+    unordered_map<string, uint32_t> dictionaryIndex;
+    size_t rows = 0;
+    
+    // Тексты словаря, заранее экранированные для CSV или JSON: одна строка на значение, не на ячейку
+    vector<string> encodeDictionary(bool json) const {
+        vector<string> encoded(dictionary.size());
+        for (size_t i = 0; i < dictionary.size(); ++i) {
+            if (json) {
+                encoded[i] += '"';
+                appendEscaped(encoded[i], dictionary[i]);
+                encoded[i] += '"';
+            } else {
+                appendCsvField(encoded[i], dictionary[i]);
+            }
+        }
+        return encoded;
+    }
+    
+    static void appendDigits(char* p, int value, int width) {
+        for (int i = width - 1; i >= 0; --i) {
+            p[i] = (char)('0' + value % 10);
+            value /= 10;
+        }
+    }
+    
+    void appendCell(string& out, size_t col, size_t row, const vector<string>& texts, bool json) const {
+        const Column& column = columns[col];
+        char buf[64];
+        switch (column.type) {
+            case Text:
+                out += texts[column.values[row]];
+                break;
+            case Integer: {
+                auto res = to_chars(buf, buf + sizeof(buf), column.values[row]);
+                out.append(buf, res.ptr);
+                break;
+            }
+            case Decimal: {
+                long long value = column.values[row];
+                char* p = buf;
+                if (value < 0) {
+                    *p++ = '-';
+                    value = -value;
+                }
+                p = to_chars(p, buf + sizeof(buf), value / 100).ptr;
+                *p++ = '.';
+                appendDigits(p, (int)(value % 100), 2);
+                out.append(buf, p + 2);
+                break;
+            }
+            case Date: {
+                int y, m, d;
+                civilFromDays(column.values[row], y, m, d);
+                char* p = buf;
+                if (json) *p++ = '"';
+                appendDigits(p, y, 4);
+                p[4] = '-';
+                appendDigits(p + 5, m, 2);
+                p[7] = '-';
+                appendDigits(p + 8, d, 2);
+                p += 10;
+                if (json) *p++ = '"';
+                out.append(buf, p);
+                break;
+            }
+        }
+    }
+    
+    void appendCsvRows(string& out, size_t from, size_t to, const vector<string>& texts) const {
+        for (size_t row = from; row < to; ++row) {
+            for (size_t col = 0; col < columns.size(); ++col) {
+                if (col) out += ',';
+                appendCell(out, col, row, texts, false);
+            }
+            out += '\n';
+        }
+    }
+    
+    void appendCsvHeader(string& out) const {
+        for (size_t col = 0; col < columns.size(); ++col) {
+            if (col) out += ',';
+            appendCsvField(out, columns[col].name);
+        }
+        out += '\n';
+    }
+    
+    static void appendEscaped(string& out, const string& text) {
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (c == '\n') {
+                out += "\\n";
+            } else if ((unsigned char)c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    
+    static void appendCsvField(string& out, const string& text) {
+        if (text.find_first_of(",\"\n") == string::npos) {
+            out += text;
+            return;
+        }
+        out += '"';
+        for (char c : text) {
+            if (c == '"') out += '"';
+            out += c;
+        }
+        out += '"';
+    }
+public:
+    size_t addColumn(const string& name, ColumnType type) {
+        columns.push_back(Column{name, type, {}});
+        return columns.size() - 1;
+    }
+    
+    // Код строки в словаре отчета; одинаковые строки хранятся один раз
+    uint32_t intern(const string& text) {
+        auto it = dictionaryIndex.find(text);
+        if (it != dictionaryIndex.end()) return it->second;
+        uint32_t code = (uint32_t)dictionary.size();
+        dictionary.push_back(text);
+        dictionaryIndex.emplace(text, code);
+        return code;
+    }
+    
+    void reserve(size_t rowCount) {
+        for (auto& column : columns) {
+            column.values.reserve(rowCount);
+        }
+    }
+    
+    // Значения по порядку колонок
+    void addRow(initializer_list<Cell> cells) {
+        size_t col = 0;
+        for (const Cell& cell : cells) {
+            if (col == columns.size()) break;
+            Column& column = columns[col++];
+            if (column.type == Decimal && cell.type != Decimal) {
+                column.values.push_back(cell.value * 100);
+            } else if (column.type != Decimal && cell.type == Decimal) {
+                column.values.push_back(cell.value / 100);
+            } else {
+                column.values.push_back(cell.value);
+            }
+        }
+        for (; col < columns.size(); ++col) {
+            columns[col].values.push_back(0);
+        }
+        rows++;
+    }
+    
+    // Новый отчет: ключевые колонки (не больше четырех), суммы числовых колонок и число строк.
+    // Группы ищутся в хэш-таблице с открытой адресацией по составному ключу.
+    ReportBuilder groupBy(const vector<size_t>& keys, const vector<size_t>& sums) const {
+        typedef array<long long, 4> Key;
+        if (keys.size() > Key().size()) throw invalid_argument("groupBy supports at most 4 key columns");
+        ReportBuilder result;
+        for (size_t k : keys) result.addColumn(columns[k].name, columns[k].type);
+        for (size_t s : sums) result.addColumn(columns[s].name, columns[s].type);
+        size_t countColumn = result.addColumn("rows", Integer);
+        result.dictionary = dictionary;
+        result.dictionaryIndex = dictionaryIndex;
+        size_t keyCount = keys.size();
+        
+        vector<Key> slotKeys(1024);
+        vector<uint32_t> slotGroups(1024, UINT32_MAX);
+        size_t mask = 1023;
+        auto hashKey = [&](const Key& k) {
+            uint64_t h = 1469598103934665603ULL;
+            for (size_t i = 0; i < keyCount; ++i) h = (h ^ (uint64_t)k[i]) * 0x100000001b3ULL;
+            return (size_t)(h ^ (h >> 29));
+        };
+        
+        Key key{};
+        for (size_t row = 0; row < rows; ++row) {
+            for (size_t i = 0; i < keyCount; ++i) {
+                key[i] = columns[keys[i]].values[row];
+            }
+            size_t slot = hashKey(key) & mask;
+            while (slotGroups[slot] != UINT32_MAX && slotKeys[slot] != key) {
+                slot = (slot + 1) & mask;
+            }
+            uint32_t group = slotGroups[slot];
+            if (group == UINT32_MAX) {
+                group = (uint32_t)result.rows++;
+                slotKeys[slot] = key;
+                slotGroups[slot] = group;
+                for (size_t i = 0; i < result.columns.size(); ++i) {
+                    result.columns[i].values.push_back(i < keyCount ? key[i] : 0);
+                }
+                // Заполнение больше половины - увеличиваем таблицу вдвое
+                if (result.rows * 2 > slotGroups.size()) {
+                    vector<Key> oldKeys(slotKeys.size() * 2);
+                    vector<uint32_t> oldGroups(slotGroups.size() * 2, UINT32_MAX);
+                    oldKeys.swap(slotKeys);
+                    oldGroups.swap(slotGroups);
+                    mask = slotGroups.size() - 1;
+                    for (size_t i = 0; i < oldGroups.size(); ++i) {
+                        if (oldGroups[i] == UINT32_MAX) continue;
+                        size_t s = hashKey(oldKeys[i]) & mask;
+                        while (slotGroups[s] != UINT32_MAX) s = (s + 1) & mask;
+                        slotKeys[s] = oldKeys[i];
+                        slotGroups[s] = oldGroups[i];
+                    }
+                }
+            }
+            for (size_t i = 0; i < sums.size(); ++i) {
+                result.columns[keyCount + i].values[group] += columns[sums[i]].values[row];
+            }
+            result.columns[countColumn].values[group]++;
+        }
+        return result;
+    }
+    
+    void writeCsv(string& out) const {
+        vector<string> texts = encodeDictionary(false);
+        appendCsvHeader(out);
+        appendCsvRows(out, 0, rows, texts);
+    }
+    
+    void writeJson(string& out) const {
+        vector<string> texts = encodeDictionary(true);
+        vector<string> names;
+        for (const auto& column : columns) {
+            string name = "\"";
+            appendEscaped(name, column.name);
+            names.push_back(name + "\":");
+        }
+        out += '[';
+        for (size_t row = 0; row < rows; ++row) {
+            out += row ? ",{" : "{";
+            for (size_t col = 0; col < columns.size(); ++col) {
+                if (col) out += ',';
+                out += names[col];
+                appendCell(out, col, row, texts, true);
+            }
+            out += '}';
+        }
+        out += ']';
+    }
+    
+    // Потоковый вывод: буфер сбрасывается в поток порциями примерно по chunkSize байт
+    void streamCsv(ostream& os, size_t chunkSize = 1 << 20) const {
+        vector<string> texts = encodeDictionary(false);
+        string buffer;
+        buffer.reserve(chunkSize + 4096);
+        appendCsvHeader(buffer);
+        const size_t step = 1024;
+        for (size_t row = 0; row < rows; row += step) {
+            appendCsvRows(buffer, row, min(rows, row + step), texts);
+            if (buffer.size() >= chunkSize) {
+                os.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+        os.write(buffer.data(), buffer.size());
+    }
+    
+    size_t rowCount() const { return rows; }
+};
+
+// Журнал учета времени: компактные записи (задача, пользователь, время, минуты) только добавляются.
+// При добавлении сразу обновляются итоги по пользователю, задаче, дню, а также по пользователю
+// за день и за неделю, поэтому такие запросы - поиск в хэш-таблице без просмотра журнала.
+// Дни и недели считаются по UTC, неделя начинается с понедельника.
+class TimeLog {
+public:
+    struct Entry {
+        uint32_t task;
+        uint32_t user;
+        int64_t timestamp;
+        uint32_t minutes;
+    };
+private:
+    vector<Entry> entries;
+    vector<string> taskIds, userIds;
+    unordered_map<string, uint32_t> taskIndex, userIndex;
+    vector<long long> minutesByTask, minutesByUser;
+    unordered_map<long long, long long> minutesByDay;
+    unordered_map<uint64_t, long long> minutesByUserDay;
+    unordered_map<uint64_t, long long> minutesByUserWeek;
+    long long totalMinutes = 0;
+    mutable shared_mutex logMutex;
+    
+    static uint32_t internId(const string& id, vector<string>& ids, unordered_map<string, uint32_t>& index,
+                             vector<long long>& totals) {
+        auto it = index.find(id);
+        if (it != index.end()) return it->second;
+        uint32_t code = (uint32_t)ids.size();
+        ids.push_back(id);
+        index.emplace(id, code);
+        totals.push_back(0);
+        return code;
+    }
+    
+    static uint64_t userPeriodKey(uint32_t user, long long period) {
+        return (uint64_t)user << 32 | (uint32_t)period;
+    }
+    
+    template <typename Map, typename Key>
+    static long long lookup(const Map& map, const Key& key) {
+        auto it = map.find(key);
+        return it != map.end() ? it->second : 0;
+    }
+    
+    long long userTotal(const string& userId, const unordered_map<uint64_t, long long>& rollup, long long period) const {
+        auto it = userIndex.find(userId);
+        return it != userIndex.end() ? lookup(rollup, userPeriodKey(it->second, period)) : 0;
+    }
+public:
+    static long long dayOf(time_t timestamp) {
+        return timestamp >= 0 ? timestamp / 86400 : (timestamp - 86399) / 86400;
+    }
+    
+    // 1970-01-01 - четверг, поэтому сдвиг на 3 дня дает недели с понедельника
+    static long long weekOf(long long day) {
+        return day + 3 >= 0 ? (day + 3) / 7 : (day + 3 - 6) / 7;
+    }
+    
+    void log(const string& taskId, const string& userId, time_t timestamp, uint32_t minutes) {
+        unique_lock<shared_mutex> lck(logMutex);
+        uint32_t task = internId(taskId, taskIds, taskIndex, minutesByTask);
+        uint32_t user = internId(userId, userIds, userIndex, minutesByUser);
+        entries.push_back(Entry{task, user, (int64_t)timestamp, minutes});
+        long long day = dayOf(timestamp);
+        minutesByTask[task] += minutes;
+        minutesByUser[user] += minutes;
+        minutesByDay[day] += minutes;
+        minutesByUserDay[userPeriodKey(user, day)] += minutes;
+        minutesByUserWeek[userPeriodKey(user, weekOf(day))] += minutes;
+        totalMinutes += minutes;
+    }
+    
+    long long minutesForUser(const string& userId) const {
+        shared_lock<shared_mutex> lck(logMutex);
+        auto it = userIndex.find(userId);
+        return it != userIndex.end() ? minutesByUser[it->second] : 0;
+    }
+    
+    long long minutesForTask(const string& taskId) const {
+        shared_lock<shared_mutex> lck(logMutex);
+        auto it = taskIndex.find(taskId);
+        return it != taskIndex.end() ? minutesByTask[it->second] : 0;
+    }
+    
+    long long minutesOnDay(time_t when) const {
+        shared_lock<shared_mutex> lck(logMutex);
+        return lookup(minutesByDay, dayOf(when));
+    }
+    
+    long long minutesForUserOnDay(const string& userId, time_t when) const {
+        shared_lock<shared_mutex> lck(logMutex);
+        return userTotal(userId, minutesByUserDay, dayOf(when));
+    }
+    
+    // Минуты пользователя за неделю, в которую попадает момент when
+    long long minutesForUserInWeek(const string& userId, time_t when) const {
+        shared_lock<shared_mutex> lck(logMutex);
+        return userTotal(userId, minutesByUserWeek, weekOf(dayOf(when)));
+    }
+    
+    long long getTotalMinutes() const {
+        shared_lock<shared_mutex> lck(logMutex);
+        return totalMinutes;
+    }
+    
+    size_t size() const {
+        shared_lock<shared_mutex> lck(logMutex);
+        return entries.size();
+    }
+    
+    // Все записи журнала как отчет: пользователь, задача, день, минуты
+    ReportBuilder toReport() const {
+        shared_lock<shared_mutex> lck(logMutex);
+        ReportBuilder report;
+        report.addColumn("user", ReportBuilder::Text);
+        report.addColumn("task", ReportBuilder::Text);
+        report.addColumn("day", ReportBuilder::Date);
+        report.addColumn("minutes", ReportBuilder::Integer);
+        report.reserve(entries.size());
+        vector<uint32_t> userCodes, taskCodes;
+        for (const auto& id : userIds) userCodes.push_back(report.intern(id));
+        for (const auto& id : taskIds) taskCodes.push_back(report.intern(id));
+        for (const Entry& e : entries) {
+            report.addRow({ReportBuilder::Cell::text(userCodes[e.user]), ReportBuilder::Cell::text(taskCodes[e.task]),
+                           ReportBuilder::Cell::date(dayOf(e.timestamp)), ReportBuilder::Cell::number(e.minutes)});
+        }
+        return report;
     }
 };
 
@@ -93,34 +1338,250 @@ private:
     string id;
     string name;
     vector<Task> tasks;
+    unordered_map<string, size_t> taskIndex; // id задачи -> позиция в tasks
     vector<User> members;
     vector<ExternalAPI> integrations;
+    unordered_map<string, size_t> integrationIndex; // имя API -> позиция в integrations
+    TimeLog timeLog;
 public:
     Project(string id, string name) : id(id), name(name) {}
     
     void addMember(User user) { members.push_back(user); }
-    void addTask(Task task) { tasks.push_back(task); }
-    void addIntegration(ExternalAPI api) { integrations.push_back(api); }
+    // Часы, списанные на задачу до добавления в проект, переносятся в журнал на исполнителя:
+    // дальше все часы проекта считаются только по журналу
+    void addTask(Task task) {
+        taskIndex[task.getId()] = tasks.size();
+        tasks.push_back(task);
+        if (task.getActualHours() > 0) {
+            timeLog.log(task.getId(), task.getAssignee() ? task.getAssignee()->getId() : string(),
+                        time(nullptr), task.getActualHours() * 60);
+        }
+    }
     
-    void syncWithAPI(string apiName) {
-        for (auto& api : integrations) {
-            if (apiName == api.getName()) {
-                string data = api.getData("tasks");
-                cout << "Synced data from " << apiName << ": " << data << endl;
-            }
+    // Записывает, кто и когда работал над задачей
+    bool logHours(const string& taskId, const User& user, int hours, time_t when = time(nullptr)) {
+        if (!taskIndex.count(taskId) || hours <= 0) return false;
+        timeLog.log(taskId, user.getId(), when, hours * 60);
+        return true;
+    }
+    
+    int getTaskHours(const string& taskId) const { return (int)(timeLog.minutesForTask(taskId) / 60); }
+    
+    const TimeLog& getTimeLog() const { return timeLog; }
+    void addIntegration(ExternalAPI api) {
+        auto it = integrationIndex.find(api.getName());
+        if (it != integrationIndex.end()) {
+            integrations[it->second] = api;
+        } else {
+            integrationIndex[api.getName()] = integrations.size();
+            integrations.push_back(api);
+        }
+    }
+    
+    const ExternalAPI* findIntegration(const string& apiName) const {
+        auto it = integrationIndex.find(apiName);
+        return it != integrationIndex.end() ? &integrations[it->second] : nullptr;
+    }
+    
+    void syncWithAPI(const string& apiName) {
+        if (const ExternalAPI* api = findIntegration(apiName)) {
+            string data = api->getData("tasks");
+            cout << "Synced data from " << apiName << ": " << data << endl;
         }
     }
     
+    const string& getId() const { return id; }
+    const vector<ExternalAPI>& getIntegrations() const { return integrations; }
+    
     void generateTimeReport() {
         Report report("TIME-001", "Time Tracking Report");
-        int totalHours = 0;
-        for (const auto& task : tasks) {
-            totalHours += task.getActualHours();
-        }
         report.addData("Total tasks", to_string(tasks.size()));
-        report.addData("Total hours logged", to_string(totalHours));
+        report.addData("Total hours logged", to_string(timeLog.getTotalMinutes() / 60));
+        time_t now = time(nullptr);
+        for (const auto& member : members) {
+            report.addData("This week: " + member.getName(),
+                           to_string(timeLog.minutesForUserInWeek(member.getId(), now) / 60) + " h");
+        }
         report.generate();
     }
+    
+    // Часы по задачам проекта в виде таблицы: проект, задача, исполнитель, часы
+    ReportBuilder buildTimeReport() const {
+        ReportBuilder report;
+        report.addColumn("project", ReportBuilder::Text);
+        report.addColumn("task", ReportBuilder::Text);
+        report.addColumn("user", ReportBuilder::Text);
+        report.addColumn("hours", ReportBuilder::Integer);
+        report.reserve(tasks.size());
+        uint32_t project = report.intern(id);
+        uint32_t unassigned = report.intern("");
+        for (const auto& task : tasks) {
+            uint32_t user = task.getAssignee() ? report.intern(task.getAssignee()->getName()) : unassigned;
+            report.addRow({ReportBuilder::Cell::text(project), ReportBuilder::Cell::text(report.intern(task.getId())),
+                           ReportBuilder::Cell::text(user), ReportBuilder::Cell::number(getTaskHours(task.getId()))});
+        }
+        return report;
+    }
+};
+
+// Ограничитель частоты запросов: rate токенов в секунду, не более burst подряд
+class TokenBucket {
+private:
+    typedef chrono::steady_clock Clock;
+    double rate;
+    double burst;
+    double tokens;
+    Clock::time_point last;
+    mutex mtx;
+public:
+    TokenBucket(double rate, double burst)
+        : rate(rate), burst(max(1.0, burst)), tokens(max(1.0, burst)), last(Clock::now()) {}
+    
+    // Ждет, пока не появится токен; при rate <= 0 ограничения нет
+    void acquire() {
+        if (rate <= 0) return;
+        while (true) {
+            chrono::duration<double> wait;
+            {
+                lock_guard<mutex> lck(mtx);
+                auto now = Clock::now();
+                tokens = min(burst, tokens + chrono::duration<double>(now - last).count() * rate);
+                last = now;
+                if (tokens >= 1) {
+                    tokens -= 1;
+                    return;
+                }
+                wait = chrono::duration<double>((1 - tokens) / rate);
+            }
+            this_thread::sleep_for(wait);
+        }
+    }
+};
+
+// Синхронизация многих проектов с общими внешними API на пуле потоков.
+// Для каждого API (по имени) действует свой лимит запросов из config: rate_limit (в секунду)
+// и rate_burst. Повторная синхронизация запрашивает только изменения с момента прошлой.
+class SyncScheduler {
+public:
+    struct ApiStats {
+        string name;
+        long requests = 0;
+        long errors = 0;
+        double throughput = 0;      // запросов в секунду между первым и последним запросом к этому API
+        double averageLatencyMs = 0;
+        double maxLagSeconds = 0;   // давность самой старой успешной синхронизации проекта
+    };
+private:
+    struct ApiState {
+        ExternalAPI api;            // настройки берутся у первого проекта с этим API
+        TokenBucket bucket;
+        AsyncApiClient client;
+        atomic<long> requests{0};
+        atomic<long> errors{0};
+        atomic<long long> latencyUs{0};
+        atomic<long long> firstNs{0};   // начало первого и конец последнего запроса прогона, нс steady_clock
+        atomic<long long> lastNs{0};
+        
+        // Окно запросов расширяется без блокировки: CAS до тех пор, пока значение не станет крайним
+        void widenWindow(long long startNs, long long endNs) {
+            long long seen = firstNs.load();
+            while (startNs < seen && !firstNs.compare_exchange_weak(seen, startNs)) {}
+            seen = lastNs.load();
+            while (endNs > seen && !lastNs.compare_exchange_weak(seen, endNs)) {}
+        }
+        
+        ApiState(const ExternalAPI& source)
+            : api(source),
+              bucket(atof(source.getConfig("rate_limit").c_str()), atof(source.getConfig("rate_burst").c_str())),
+              client(api) {}
+    };
+    
+    struct Job {
+        const Project* project;
+        const ExternalAPI* api;
+        ApiState* state;
+        time_t* watermark;
+    };
+    
+    unsigned threadCount;
+    map<string, unique_ptr<ApiState>> apis;
+    unordered_map<string, time_t> watermarks; // "проект/API" -> время последней успешной синхронизации
+    atomic<long> changes{0};
+public:
+    SyncScheduler(unsigned threads = 16) : threadCount(max(1u, threads)) {}
+    
+    vector<ApiStats> syncAll(const vector<Project*>& projects) {
+        // Задания и их отметки времени готовятся заранее, потоки только читают эти структуры
+        vector<Job> jobs;
+        for (const Project* project : projects) {
+            for (const auto& api : project->getIntegrations()) {
+                auto& state = apis[api.getName()];
+                if (!state) state.reset(new ApiState(api));
+                jobs.push_back(Job{project, &api, state.get(), &watermarks[project->getId() + "/" + api.getName()]});
+            }
+        }
+        for (auto& entry : apis) {
+            entry.second->requests = 0;
+            entry.second->errors = 0;
+            entry.second->latencyUs = 0;
+            entry.second->firstNs = numeric_limits<long long>::max();
+            entry.second->lastNs = 0;
+        }
+        
+        atomic<size_t> nextJob{0};
+        auto nanos = [](chrono::steady_clock::time_point t) {
+            return (long long)chrono::duration_cast<chrono::nanoseconds>(t.time_since_epoch()).count();
+        };
+        auto work = [&]() {
+            size_t i;
+            while ((i = nextJob.fetch_add(1)) < jobs.size()) {
+                Job& job = jobs[i];
+                time_t syncStart = time(nullptr);
+                string query = "tasks?project=" + job.project->getId() + "&changed_since=" + to_string(*job.watermark);
+                job.state->bucket.acquire();
+                auto requestStart = chrono::steady_clock::now();
+                try {
+                    string data = job.state->client.get(query);
+                    *job.watermark = syncStart;
+                    if (!data.empty()) changes++;
+                } catch (const exception&) {
+                    job.state->errors++;
+                }
+                auto requestEnd = chrono::steady_clock::now();
+                job.state->requests++;
+                job.state->latencyUs += chrono::duration_cast<chrono::microseconds>(requestEnd - requestStart).count();
+                job.state->widenWindow(nanos(requestStart), nanos(requestEnd));
+            }
+        };
+        vector<thread> workers;
+        for (unsigned t = 0; t < threadCount; ++t) {
+            workers.emplace_back(work);
+        }
+        for (auto& w : workers) {
+            w.join();
+        }
+        time_t now = time(nullptr);
+        map<string, double> lag;
+        for (const Job& job : jobs) {
+            double& worst = lag[job.api->getName()];
+            worst = max(worst, difftime(now, *job.watermark));
+        }
+        vector<ApiStats> result;
+        for (auto& entry : apis) {
+            ApiState& state = *entry.second;
+            ApiStats stats;
+            stats.name = entry.first;
+            stats.requests = state.requests;
+            stats.errors = state.errors;
+            // Делится на окно запросов самого API: ожидание в очереди за другими API в него не входит
+            double seconds = state.lastNs > state.firstNs ? (state.lastNs - state.firstNs) / 1e9 : 0;
+            stats.throughput = seconds > 0 ? stats.requests / seconds : 0;
+            stats.averageLatencyMs = stats.requests ? state.latencyUs / 1000.0 / stats.requests : 0;
+            stats.maxLagSeconds = lag[entry.first];
+            result.push_back(stats);
+        }
+        return result;
+    }
 };
 
 int main() {
@@ -138,6 +1599,8 @@ int main() {
     t1.assignTo(&u1);
     t1.logHours(5);
     p.addTask(t1);
+    p.logHours("T1001", u1, 3);
+    p.logHours("T1001", u2, 2);
     
     // Настраиваем интеграцию с API
     ExternalAPI jira("Jira", "https://api.jira.com");
@@ -147,8 +1610,181 @@ int main() {
     // Синхронизируем данные
     p.syncWithAPI("Jira");
     
+#ifndef _WIN32
+    // Асинхронный клиент против локальной заглушки с задержкой 50 мс
+    {
+        StubApiServer stub(50);
+        ExternalAPI local("LocalStub", stub.getEndpoint());
+        local.setConfig("max_connections", "8");
+        local.setConfig("cache_ttl_ms", "1000");
+        local.setConfig("api_key", "12345");
+        AsyncApiClient client(local);
+        
+        auto start = chrono::steady_clock::now();
+        vector<shared_future<string>> results;
+        for (int i = 0; i < 64; ++i) {
+            results.push_back(client.getAsync("tasks?project=P" + to_string(i % 16)));
+        }
+        for (auto& result : results) {
+            result.get();
+        }
+        auto firstMs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < 64; ++i) {
+            client.get("tasks?project=P" + to_string(i % 16));
+        }
+        auto cachedUs = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+        
+        cout << "Sample response: " << results[0].get() << endl;
+        cout << "64 requests (16 distinct) in " << firstMs << " ms, repeated from cache in " << cachedUs << " us" << endl;
+        cout << "Stub served " << stub.getServed() << ", network requests " << client.getNetworkRequests()
+             << ", coalesced " << client.getCoalesced() << ", cache hits " << client.getCacheHits()
+             << ", connections opened " << client.getConnectionsOpened() << endl;
+    }
+#endif
+    
     // Генерируем отчет
     p.generateTimeReport();
+    string projectJson;
+    p.buildTimeReport().writeJson(projectJson);
+    cout << projectJson << endl;
+    
+    // Журнал времени с готовыми итогами: часы за неделю по каждому сотруднику без просмотра журнала
+    {
+        TimeLog orgLog;
+        vector<string> staff;
+        for (int i = 0; i < 200; ++i) staff.push_back("U3" + to_string(i));
+        mt19937 rng(9);
+        const time_t yearStart = 1672531200; // 2023-01-01 00:00 UTC
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < 1000000; ++i) {
+            orgLog.log("T" + to_string(rng() % 2000), staff[rng() % staff.size()],
+                       yearStart + (time_t)(rng() % (365 * 86400)), 15 + rng() % 240);
+        }
+        auto logMs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+        const time_t someDay = 1686830400; // 2023-06-15
+        start = chrono::steady_clock::now();
+        long long weekMinutes = 0;
+        for (const auto& member : staff) {
+            weekMinutes += orgLog.minutesForUserInWeek(member, someDay);
+        }
+        auto lookupNs = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count() / staff.size();
+        cout << "Time log: " << orgLog.size() << " entries logged in " << logMs << " ms; week of 2023-06-15: "
+             << weekMinutes / 60 << " h across " << staff.size() << " members, " << lookupNs << " ns per lookup; "
+             << "U30 that day " << orgLog.minutesForUserOnDay("U30", someDay) << " min" << endl;
+        ReportBuilder perMember = orgLog.toReport().groupBy({0}, {3});
+        string perMemberCsv;
+        perMember.writeCsv(perMemberCsv);
+        cout << "Per-member totals: " << perMember.rowCount() << " rows, " << perMemberCsv.size() << " bytes of CSV" << endl;
+    }
+    
+    // Отчет по всей организации: миллионы записей о времени, группировка по пользователю, задаче и дню
+    {
+        const int entries = 2000000;
+        ReportBuilder log;
+        size_t userCol = log.addColumn("user", ReportBuilder::Text);
+        size_t taskCol = log.addColumn("task", ReportBuilder::Text);
+        size_t dayCol = log.addColumn("day", ReportBuilder::Date);
+        size_t minutesCol = log.addColumn("minutes", ReportBuilder::Integer);
+        size_t costCol = log.addColumn("cost", ReportBuilder::Decimal);
+        log.reserve(entries);
+        vector<uint32_t> userCodes, taskCodes;
+        for (int i = 0; i < 500; ++i) userCodes.push_back(log.intern("user" + to_string(i)));
+        for (int i = 0; i < 5000; ++i) taskCodes.push_back(log.intern("T" + to_string(i)));
+        const long long firstDay = 19358; // 2023-01-01
+        mt19937 rng(5);
+        for (int i = 0; i < entries; ++i) {
+            int minutes = 15 + rng() % 240;
+            log.addRow({ReportBuilder::Cell::text(userCodes[rng() % userCodes.size()]),
+                        ReportBuilder::Cell::text(taskCodes[rng() % taskCodes.size()]),
+                        ReportBuilder::Cell::date(firstDay + rng() % 365),
+                        ReportBuilder::Cell::number(minutes),
+                        ReportBuilder::Cell::decimalValue(minutes * 0.75)});
+        }
+        
+        auto start = chrono::steady_clock::now();
+        ReportBuilder byUserDay = log.groupBy({userCol, dayCol}, {minutesCol, costCol});
+        ReportBuilder byTask = log.groupBy({taskCol}, {minutesCol, costCol});
+        auto groupMs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+        
+        start = chrono::steady_clock::now();
+        string csv, json;
+        csv.reserve(64 << 20);
+        json.reserve(128 << 20);
+        log.writeCsv(csv);
+        byUserDay.writeJson(json);
+        byTask.writeJson(json);
+        auto serializeMs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+        
+        cout << "Organization report: " << entries << " entries grouped into " << byUserDay.rowCount()
+             << " user/day and " << byTask.rowCount() << " task rows in " << groupMs << " ms; CSV "
+             << csv.size() / (1 << 20) << " MB + JSON " << json.size() / (1 << 20) << " MB serialized in "
+             << serializeMs << " ms" << endl;
+        cout << csv.substr(0, csv.find('\n', csv.find('\n') + 1) + 1);
+    }
+    
+#ifndef _WIN32
+    // Параллельная синхронизация тысячи проектов с двумя общими API
+    {
+        StubApiServer tracker(1);
+        deque<Project> portfolio;
+        vector<Project*> projects;
+        for (int i = 0; i < 1000; ++i) {
+            portfolio.emplace_back("P" + to_string(2000 + i), "Project " + to_string(i));
+            ExternalAPI jiraApi("Jira", "https://api.jira.com");
+            jiraApi.setConfig("offline_mock", "1");   // TLS клиент не поддерживает: ответы дает заглушка
+            jiraApi.setConfig("rate_limit", "4000");
+            jiraApi.setConfig("rate_burst", "100");
+            portfolio.back().addIntegration(jiraApi);
+            ExternalAPI trackerApi("TimeTracker", tracker.getEndpoint());
+            trackerApi.setConfig("rate_limit", "2000");
+            trackerApi.setConfig("rate_burst", "50");
+            trackerApi.setConfig("max_connections", "8");
+            portfolio.back().addIntegration(trackerApi);
+            projects.push_back(&portfolio.back());
+        }
+        SyncScheduler scheduler(16);
+        for (const char* pass : {"Full", "Incremental"}) {
+            for (const auto& stats : scheduler.syncAll(projects)) {
+                cout << pass << " sync " << stats.name << ": " << stats.requests << " requests, " << stats.errors
+                     << " errors, " << (long)stats.throughput << " req/s, avg latency " << stats.averageLatencyMs
+                     << " ms, max lag " << stats.maxLagSeconds << " s" << endl;
+            }
+        }
+    }
+#endif
+    
+    // Уведомления отправляются фоновым диспетчером дайджестами по получателям
+    {
+        StdoutSink console;
+        NotificationDispatcher dispatcher(console, 100, chrono::milliseconds(100));
+        dispatcher.post(Notification("comment", "New comment on Design homepage", &u1));
+        dispatcher.post(Notification("status", "Design homepage moved to In Progress", &u1));
+        dispatcher.post(Notification("assignment", "You were added to Website Redesign", &u2));
+        dispatcher.stop();
+    }
+    
+#ifndef _WIN32
+    // Нагрузка через SMTP-заглушку, которая первые 3 письма отклоняет: видны повторы с задержкой
+    {
+        SmtpStubServer smtp(3);
+        SmtpSink mail("127.0.0.1", smtp.getPort(), "noreply@example.com");
+        vector<User> recipients;
+        for (int i = 0; i < 50; ++i) {
+            recipients.emplace_back("U2" + to_string(i), "User " + to_string(i), "user" + to_string(i) + "@example.com");
+        }
+        NotificationDispatcher dispatcher(mail, 1000, chrono::milliseconds(50));
+        for (int i = 0; i < 20000; ++i) {
+            dispatcher.post(Notification("update", "Task T" + to_string(i) + " updated", &recipients[i % recipients.size()]));
+        }
+        dispatcher.stop();
+        auto m = dispatcher.getMetrics();
+        cout << "Dispatcher: " << m.notifications << " notifications in " << m.batches << " digests (avg "
+             << m.averageBatchSize << "), " << m.retries << " retries, " << m.dropped << " dropped, max queue depth "
+             << m.maxQueueDepth << ", latency avg " << m.averageLatencyMs << " ms / max " << m.maxLatencyMs
+             << " ms, SMTP accepted " << smtp.getAccepted() << endl;
+    }
+#endif
     
     return 0;
 }
\ No newline at end of file
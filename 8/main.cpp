@@ -1,6 +1,24 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <unordered_set>
+#include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <cstdio>
+#include <cctype>
+#include <cstring>
+#include <string_view>
+#include <sstream>
 
 using namespace std;
 
@@ -27,10 +45,188 @@ public:
     Participant(const string &fn, const string &ln, const string &em)
         : firstName(fn), lastName(ln), email(em) {}
     virtual ~Participant() {};
+    const string &getFirstName() const { return firstName; };
+    const string &getLastName() const { return lastName; };
     string getFullName() const { return firstName + " " + lastName; };
     string getEmail() const { return email; };
 };
 
+// Ссылка на участника в реестре
+struct ParticipantHandle {
+    uint32_t index = UINT32_MAX;
+    bool valid() const { return index != UINT32_MAX; };
+};
+
+// Хранилище строк блоками: строки не перемещаются, поэтому на них можно держать string_view
+class StringArena {
+protected:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+    vector<unique_ptr<char[]>> chunks;
+    size_t used = CHUNK_SIZE;
+    size_t totalBytes = 0;
+public:
+    StringArena() {}
+    virtual ~StringArena() {};
+    string_view store(string_view text) {
+        if (text.size() > CHUNK_SIZE) {
+            // Большая строка получает свой блок, текущий блок продолжает заполняться
+            auto it = chunks.insert(chunks.empty() ? chunks.end() : chunks.end() - 1, unique_ptr<char[]>(new char[text.size()]));
+            memcpy(it->get(), text.data(), text.size());
+            totalBytes += text.size();
+            return string_view(it->get(), text.size());
+        }
+        if (used + text.size() > CHUNK_SIZE) {
+            chunks.emplace_back(new char[CHUNK_SIZE]);
+            used = 0;
+        }
+        char *dst = chunks.back().get() + used;
+        memcpy(dst, text.data(), text.size());
+        used += text.size();
+        totalBytes += text.size();
+        return string_view(dst, text.size());
+    }
+    size_t sizeInBytes() const { return totalBytes; };
+};
+
+// Реестр участников: имена и адреса хранятся один раз в арене, участники дедуплицируются
+// по нормализованному email. Регистрация выполняется одним потоком, чтение - из любых.
+class ParticipantRegistry {
+public:
+    struct ImportStats {
+        size_t rows = 0;
+        size_t added = 0;
+        size_t duplicates = 0;
+        size_t invalid = 0;
+    };
+protected:
+    struct Record {
+        string_view fullName;   // "Имя Фамилия"
+        uint32_t firstLength;
+        string_view email;      // нормализованный
+    };
+    StringArena arena;
+    vector<Record> records;
+    unordered_map<string_view, uint32_t> byEmail;
+    string scratch;
+    string nameBuffer;
+
+    static string_view trim(string_view s) {
+        while (!s.empty() && isspace((unsigned char)s.front())) s.remove_prefix(1);
+        while (!s.empty() && isspace((unsigned char)s.back())) s.remove_suffix(1);
+        return s;
+    }
+
+    // Разбирает строку CSV из трех полей. Поле без кавычек ссылается на саму строку,
+    // поле в кавычках (может содержать запятые и "") копируется в свой буфер
+    static bool splitCsv(string_view line, string_view fields[3], string buffers[3]) {
+        size_t pos = 0;
+        for (int count = 0; count < 3; ++count) {
+            if (pos > line.size()) return false;
+            if (pos < line.size() && line[pos] == '"') {
+                string &buf = buffers[count];
+                buf.clear();
+                for (++pos;; ++pos) {
+                    if (pos >= line.size()) return false;
+                    if (line[pos] == '"') {
+                        if (pos + 1 < line.size() && line[pos + 1] == '"') ++pos;
+                        else break;
+                    }
+                    buf.push_back(line[pos]);
+                }
+                fields[count] = buf;
+                ++pos;
+                if (pos < line.size() && line[pos] != ',') return false;
+            } else {
+                size_t comma = min(line.find(',', pos), line.size());
+                fields[count] = line.substr(pos, comma - pos);
+                pos = comma;
+            }
+            ++pos;
+        }
+        return pos > line.size();
+    }
+public:
+    ParticipantRegistry() {}
+    virtual ~ParticipantRegistry() {};
+
+    // Email в нижнем регистре без пробелов по краям; пустая строка - адрес некорректен
+    static string normalizeEmail(string_view email) {
+        email = trim(email);
+        size_t at = email.find('@');
+        if (at == 0 || at == string_view::npos || at + 1 >= email.size() || email.find('@', at + 1) != string_view::npos) {
+            return string();
+        }
+        string result(email);
+        for (char &c : result) {
+            c = (char)tolower((unsigned char)c);
+        }
+        return result;
+    }
+
+    // Регистрирует участника; second == false - участник с таким email уже есть
+    pair<ParticipantHandle, bool> add(string_view firstName, string_view lastName, string_view email) {
+        scratch = normalizeEmail(email);
+        if (scratch.empty()) return {ParticipantHandle(), false};
+        auto it = byEmail.find(scratch);
+        if (it != byEmail.end()) return {ParticipantHandle{it->second}, false};
+        firstName = trim(firstName);
+        lastName = trim(lastName);
+        nameBuffer.assign(firstName).append(" ").append(lastName);
+        Record record{arena.store(nameBuffer), (uint32_t)firstName.size(), arena.store(scratch)};
+        uint32_t index = (uint32_t)records.size();
+        records.push_back(record);
+        byEmail.emplace(record.email, index);
+        return {ParticipantHandle{index}, true};
+    }
+
+    pair<ParticipantHandle, bool> add(const Participant &participant) {
+        return add(participant.getFirstName(), participant.getLastName(), participant.getEmail());
+    }
+
+    // Потоковый импорт CSV "имя,фамилия,email"; строка заголовка пропускается
+    ImportStats importCsv(istream &in) {
+        ImportStats stats;
+        string line;
+        string buffers[3];
+        bool first = true;
+        while (getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (first) {
+                first = false;
+                if (line.find('@') == string::npos) continue;
+            }
+            if (trim(line).empty()) continue;
+            stats.rows++;
+            string_view fields[3];
+            if (!splitCsv(line, fields, buffers)) {
+                stats.invalid++;
+                continue;
+            }
+            auto result = add(fields[0], fields[1], fields[2]);
+            if (result.second) stats.added++;
+            else if (result.first.valid()) stats.duplicates++;
+            else stats.invalid++;
+        }
+        return stats;
+    }
+
+    optional<ParticipantHandle> findByEmail(string_view email) const {
+        auto it = byEmail.find(normalizeEmail(email));
+        if (it == byEmail.end()) return nullopt;
+        return ParticipantHandle{it->second};
+    }
+
+    string_view getFullName(ParticipantHandle h) const { return records[h.index].fullName; };
+    string_view getFirstName(ParticipantHandle h) const { return records[h.index].fullName.substr(0, records[h.index].firstLength); };
+    string_view getLastName(ParticipantHandle h) const {
+        const Record &r = records[h.index];
+        return r.fullName.size() > r.firstLength ? r.fullName.substr(r.firstLength + 1) : string_view();
+    }
+    string_view getEmail(ParticipantHandle h) const { return records[h.index].email; };
+    size_t size() const { return records.size(); };
+    size_t arenaBytes() const { return arena.sizeInBytes(); };
+};
+
 class Ticket {
 protected:
     unsigned long ticketNumber;
@@ -69,13 +265,862 @@ public:
 
 class Feedback {
 protected:
-    string participantName;
+    ParticipantHandle participant;
     string comment;
 public:
-    Feedback(const string &pn, const string &cmt)
-        : participantName(pn), comment(cmt) {}
+    Feedback(ParticipantHandle p, const string &cmt)
+        : participant(p), comment(cmt) {}
     virtual ~Feedback() {};
-    string getComment() const { return comment; };
+    ParticipantHandle getParticipant() const { return participant; };
+    const string &getComment() const { return comment; };
+};
+
+// Отзывы об одном событии
+struct FeedbackBatch {
+    string eventName;
+    vector<Feedback> comments;
+};
+
+// Аналитика отзывов: разбиение на слова с учетом UTF-8 (русский и английский текст),
+// частоты слов по событиям и оценка тональности по словарю. Отзывы делятся между потоками
+// (map), локальные таблицы потоков затем сливаются по событиям тоже параллельно (reduce).
+class FeedbackAnalytics {
+public:
+    struct EventSummary {
+        string eventName;
+        size_t comments = 0;
+        size_t positive = 0;
+        size_t negative = 0;
+        long score = 0;
+        unordered_map<string, long> terms;
+
+        double averageScore() const { return comments ? (double)score / comments : 0.0; };
+        // Самые частые слова по убыванию частоты, при равенстве - по алфавиту
+        vector<pair<string, long>> topTerms(size_t n) const {
+            vector<pair<string, long>> all(terms.begin(), terms.end());
+            auto order = [](const pair<string, long> &a, const pair<string, long> &b) {
+                return a.second != b.second ? a.second > b.second : a.first < b.first;
+            };
+            n = min(n, all.size());
+            partial_sort(all.begin(), all.begin() + n, all.end(), order);
+            all.resize(n);
+            return all;
+        }
+    };
+    struct Result {
+        vector<EventSummary> events;
+        size_t bytes = 0;
+        size_t tokens = 0;
+        double seconds = 0;
+        double megabytesPerSecond() const { return seconds > 0 ? bytes / 1e6 / seconds : 0.0; };
+    };
+protected:
+    unsigned threadCount;
+    unordered_map<string, int> lexicon;      // основа слова -> вес
+    unordered_set<string> stopWords;
+    unordered_set<string> negations;
+    size_t minStemBytes = SIZE_MAX;
+    size_t maxStemBytes = 0;
+
+    // Декодирует один символ UTF-8; некорректный байт пропускается как U+FFFD
+    static uint32_t decode(const unsigned char *&p, const unsigned char *end) {
+        uint32_t c = *p++;
+        if (c < 0x80) return c;
+        int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : -1;
+        if (extra < 0 || end - p < extra) return 0xFFFD;
+        c &= 0x3F >> extra;
+        for (int i = 0; i < extra; ++i) {
+            if ((*p & 0xC0) != 0x80) return 0xFFFD;
+            c = c << 6 | (*p++ & 0x3F);
+        }
+        return c;
+    }
+    static void encode(uint32_t c, string &out) {
+        if (c < 0x80) {
+            out.push_back((char)c);
+        } else if (c < 0x800) {
+            out.push_back((char)(0xC0 | c >> 6));
+            out.push_back((char)(0x80 | (c & 0x3F)));
+        } else {
+            out.push_back((char)(0xE0 | c >> 12));
+            out.push_back((char)(0x80 | (c >> 6 & 0x3F)));
+            out.push_back((char)(0x80 | (c & 0x3F)));
+        }
+    }
+    // Буква или цифра в нижнем регистре; 0 - разделитель. Ё приводится к е.
+    static uint32_t foldLetter(uint32_t c) {
+        if (c < 0x80) {
+            if (c >= 'A' && c <= 'Z') return c + 32;
+            return ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) ? c : 0;
+        }
+        if (c >= 0x0410 && c <= 0x042F) return c + 0x20;
+        if (c >= 0x0430 && c <= 0x044F) return c;
+        if (c == 0x0401 || c == 0x0451) return 0x0435;
+        if (c >= 0x00C0 && c <= 0x00FF && c != 0x00D7 && c != 0x00F7) return c <= 0x00DE ? c + 0x20 : c;
+        return 0;
+    }
+
+    // Вес слова по словарю: ищется самая длинная основа, являющаяся префиксом слова.
+    // boundaries - длины префиксов токена в байтах, по одному на символ.
+    int sentimentOf(const string &token, const vector<size_t> &boundaries, string &probe) const {
+        for (size_t i = boundaries.size(); i-- > 0;) {
+            size_t len = boundaries[i];
+            if (len < minStemBytes) break;
+            if (len > maxStemBytes) continue;
+            probe.assign(token, 0, len);
+            auto it = lexicon.find(probe);
+            if (it != lexicon.end()) return it->second;
+        }
+        return 0;
+    }
+
+    // Локальный словарь потока: каждое слово классифицируется один раз,
+    // дальше на каждое вхождение - один поиск в хэш-таблице
+    enum class TokenKind : uint8_t { Stop, Negation, Term };
+    struct TokenInfo {
+        TokenKind kind;
+        int weight;
+    };
+    struct Partial {
+        unordered_map<string, uint32_t> dictionary;
+        vector<string> words;
+        vector<TokenInfo> info;
+        vector<vector<long>> counts;      // событие -> номер слова -> частота
+        vector<EventSummary> totals;
+        size_t tokens = 0;
+    };
+
+    uint32_t lookup(Partial &part, const string &token, const vector<size_t> &boundaries, string &probe) const {
+        auto it = part.dictionary.find(token);
+        if (it != part.dictionary.end()) return it->second;
+        TokenInfo info{TokenKind::Term, 0};
+        if (stopWords.count(token)) info.kind = TokenKind::Stop;
+        else if (negations.count(token)) info.kind = TokenKind::Negation;
+        else info.weight = sentimentOf(token, boundaries, probe);
+        uint32_t id = (uint32_t)part.words.size();
+        part.dictionary.emplace(token, id);
+        part.words.push_back(token);
+        part.info.push_back(info);
+        return id;
+    }
+
+    void analyzeRange(const vector<FeedbackBatch> &batches, const vector<pair<size_t, size_t>> &items,
+                      size_t begin, size_t end, Partial &out) const {
+        string token, probe;
+        vector<size_t> boundaries;
+        for (size_t i = begin; i < end; ++i) {
+            size_t e = items[i].first;
+            const string &text = batches[e].comments[items[i].second].getComment();
+            vector<long> &counts = out.counts[e];
+            EventSummary &summary = out.totals[e];
+            long score = 0;
+            bool negate = false;
+            auto flush = [&]() {
+                if (boundaries.size() >= 2) {
+                    uint32_t id = lookup(out, token, boundaries, probe);
+                    const TokenInfo &info = out.info[id];
+                    if (info.kind == TokenKind::Negation) {
+                        negate = true;
+                    } else if (info.kind == TokenKind::Term) {
+                        if (id >= counts.size()) counts.resize(out.words.size());
+                        counts[id]++;
+                        out.tokens++;
+                        score += negate ? -info.weight : info.weight;
+                        negate = false;
+                    }
+                }
+                token.clear();
+                boundaries.clear();
+            };
+            const unsigned char *p = (const unsigned char *)text.data();
+            const unsigned char *stop = p + text.size();
+            while (p < stop) {
+                uint32_t c = foldLetter(decode(p, stop));
+                if (c) {
+                    encode(c, token);
+                    boundaries.push_back(token.size());
+                } else if (!token.empty()) {
+                    flush();
+                }
+            }
+            if (!token.empty()) flush();
+            summary.comments++;
+            summary.score += score;
+            summary.positive += score > 0;
+            summary.negative += score < 0;
+        }
+    }
+public:
+    FeedbackAnalytics(unsigned threads = max(1u, thread::hardware_concurrency()))
+        : threadCount(max(1u, threads)) {
+        // Основы слов: совпадение по префиксу покрывает падежи и формы
+        const pair<const char *, int> words[] = {
+            {"отличн", 2}, {"замечательн", 2}, {"прекрасн", 2}, {"великолепн", 2}, {"хорош", 1},
+            {"интересн", 1}, {"полезн", 1}, {"понравил", 1}, {"удобн", 1}, {"спасибо", 1},
+            {"плох", -1}, {"ужасн", -2}, {"скучн", -1}, {"неудобн", -1}, {"душн", -1},
+            {"опоздал", -1}, {"разочарова", -2}, {"очеред", -1}, {"холодн", -1},
+            {"great", 2}, {"excellent", 2}, {"amazing", 2}, {"good", 1}, {"useful", 1},
+            {"interesting", 1}, {"enjoy", 1}, {"thank", 1}, {"bad", -1}, {"terrible", -2},
+            {"boring", -1}, {"awful", -2}, {"disappoint", -2}, {"late", -1}, {"crowded", -1}};
+        for (const auto &w : words) {
+            lexicon.emplace(w.first, w.second);
+            minStemBytes = min(minStemBytes, strlen(w.first));
+            maxStemBytes = max(maxStemBytes, strlen(w.first));
+        }
+        for (const char *w : {"и", "в", "во", "на", "с", "со", "по", "за", "к", "о", "об", "от", "до", "из", "что",
+                              "это", "как", "но", "а", "же", "все", "всё", "было", "был", "была", "очень", "мы", "я",
+                              "the", "a", "an", "and", "or", "of", "to", "in", "on", "at", "is", "was", "it", "we",
+                              "i", "for", "with", "very", "this", "that"}) {
+            stopWords.insert(w);
+        }
+        for (const char *w : {"не", "нет", "ни", "not", "no", "never", "isn", "wasn", "didn"}) {
+            negations.insert(w);
+        }
+    }
+    virtual ~FeedbackAnalytics() {};
+
+    Result analyze(const vector<FeedbackBatch> &batches) const {
+        auto start = chrono::steady_clock::now();
+        Result result;
+        vector<pair<size_t, size_t>> items;
+        for (size_t e = 0; e < batches.size(); ++e) {
+            for (size_t c = 0; c < batches[e].comments.size(); ++c) {
+                items.emplace_back(e, c);
+                result.bytes += batches[e].comments[c].getComment().size();
+            }
+        }
+        unsigned workers = (unsigned)min<size_t>(threadCount, max<size_t>(1, items.size()));
+        vector<Partial> partials(workers);
+        vector<thread> pool;
+        for (unsigned t = 0; t < workers; ++t) {
+            pool.emplace_back([&, t]() {
+                Partial &part = partials[t];
+                part.counts.resize(batches.size());
+                part.totals.resize(batches.size());
+                analyzeRange(batches, items, items.size() * t / workers, items.size() * (t + 1) / workers, part);
+            });
+        }
+        for (auto &t : pool) {
+            t.join();
+        }
+        pool.clear();
+
+        // Слияние: каждое событие сводит один поток, переводя номера слов потоков в строки
+        result.events.resize(batches.size());
+        atomic<size_t> nextEvent{0};
+        for (unsigned t = 0; t < workers; ++t) {
+            pool.emplace_back([&]() {
+                for (size_t e = nextEvent++; e < batches.size(); e = nextEvent++) {
+                    EventSummary &summary = result.events[e];
+                    summary.eventName = batches[e].eventName;
+                    for (const Partial &part : partials) {
+                        const EventSummary &totals = part.totals[e];
+                        summary.comments += totals.comments;
+                        summary.positive += totals.positive;
+                        summary.negative += totals.negative;
+                        summary.score += totals.score;
+                        const vector<long> &counts = part.counts[e];
+                        for (size_t id = 0; id < counts.size(); ++id) {
+                            if (counts[id]) summary.terms[part.words[id]] += counts[id];
+                        }
+                    }
+                }
+            });
+        }
+        for (auto &t : pool) {
+            t.join();
+        }
+        for (const auto &part : partials) {
+            result.tokens += part.tokens;
+        }
+        result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return result;
+    }
+};
+
+// Класс мест на площадке: название, цена и количество мест
+struct SeatClass {
+    string name;
+    double price;
+    size_t seats;
+};
+
+// Продажа билетов на событие. Места каждого класса - непрерывный участок карты мест.
+// Состояние места - одно атомарное слово: 0 - свободно, SOLD - продано, иначе - токен брони,
+// в старших битах которого записан срок действия. Поэтому бронь, подтверждение и снятие
+// просроченной брони - одна операция compare-and-swap без блокировок, и место не может
+// быть продано дважды. Счетчик remaining не дает начать бронь, когда свободных мест нет.
+class TicketSales {
+public:
+    struct Hold {
+        size_t seat;
+        uint64_t token;
+    };
+protected:
+    typedef chrono::steady_clock Clock;
+    static constexpr uint64_t SOLD = UINT64_MAX;
+    static constexpr int SEQUENCE_BITS = 20;
+    
+    struct ClassState {
+        SeatClass spec;
+        size_t firstSeat;
+        atomic<long> remaining;
+        atomic<size_t> hint{0};  // откуда начинать поиск свободного места
+        
+        ClassState(const SeatClass &sc, size_t first)
+            : spec(sc), firstSeat(first), remaining((long)sc.seats) {}
+    };
+    
+    const Event &event;
+    const Venue &venue;
+    deque<ClassState> classes;
+    vector<size_t> seatClass;                 // место -> класс
+    unique_ptr<atomic<uint64_t>[]> seatState;
+    unique_ptr<atomic<unsigned long>[]> seatTicket;
+    size_t totalSeats = 0;
+    chrono::milliseconds holdDuration;
+    Clock::time_point epoch;
+    atomic<uint64_t> holdSequence{0};
+    
+    static atomic<unsigned long> nextTicketNumber;
+    
+    uint64_t nowMs() const {
+        return (uint64_t)chrono::duration_cast<chrono::milliseconds>(Clock::now() - epoch).count();
+    }
+    
+    uint64_t makeToken() {
+        uint64_t expires = nowMs() + holdDuration.count() + 1;
+        return expires << SEQUENCE_BITS | (holdSequence.fetch_add(1) & ((1u << SEQUENCE_BITS) - 1));
+    }
+    
+    static bool takeRemaining(atomic<long> &remaining) {
+        long current = remaining.load();
+        while (current > 0) {
+            if (remaining.compare_exchange_weak(current, current - 1)) return true;
+        }
+        return false;
+    }
+    
+    // Перехватывает просроченную бронь сразу новой, счетчик remaining не меняется
+    bool reclaimExpired(size_t seat, uint64_t token) {
+        uint64_t state = seatState[seat].load();
+        if (state == 0 || state == SOLD || (state >> SEQUENCE_BITS) > nowMs()) return false;
+        return seatState[seat].compare_exchange_strong(state, token);
+    }
+    
+    bool freeSeat(size_t seat, uint64_t token) {
+        uint64_t expected = token;
+        if (!seatState[seat].compare_exchange_strong(expected, 0)) return false;
+        classes[seatClass[seat]].remaining++;
+        return true;
+    }
+public:
+    TicketSales(const Event &ev, const Venue &v, const vector<SeatClass> &seatClasses,
+                chrono::milliseconds hold = chrono::minutes(10))
+        : event(ev), venue(v), holdDuration(hold), epoch(Clock::now()) {
+        // Места сверх вместимости площадки не продаются
+        for (const auto &sc : seatClasses) {
+            size_t seats = min(sc.seats, venue.getCapacity() - totalSeats);
+            classes.emplace_back(SeatClass{sc.name, sc.price, seats}, totalSeats);
+            seatClass.insert(seatClass.end(), seats, classes.size() - 1);
+            totalSeats += seats;
+        }
+        seatState.reset(new atomic<uint64_t>[totalSeats]);
+        seatTicket.reset(new atomic<unsigned long>[totalSeats]);
+        for (size_t i = 0; i < totalSeats; ++i) {
+            seatState[i] = 0;
+            seatTicket[i] = 0;
+        }
+    }
+    virtual ~TicketSales() {};
+    
+    // Бронирует любое свободное место класса; false - мест нет
+    bool hold(size_t classIndex, Hold &result) {
+        if (classIndex >= classes.size()) return false;
+        ClassState &cls = classes[classIndex];
+        uint64_t token = makeToken();
+        size_t start = cls.hint.load();
+        if (!takeRemaining(cls.remaining)) {
+            // Свободных мест нет, но просроченные брони не ждут releaseExpired()
+            for (size_t i = 0; i < cls.spec.seats; ++i) {
+                size_t seat = cls.firstSeat + (start + i) % cls.spec.seats;
+                if (reclaimExpired(seat, token)) {
+                    result = Hold{seat, token};
+                    return true;
+                }
+            }
+            return false;
+        }
+        // Место гарантированно есть: его зарезервировал счетчик remaining
+        for (size_t i = 0;; ++i) {
+            size_t seat = cls.firstSeat + (start + i) % cls.spec.seats;
+            uint64_t expected = 0;
+            if (seatState[seat].load() == 0 && seatState[seat].compare_exchange_strong(expected, token)) {
+                cls.hint.store((seat - cls.firstSeat + 1) % cls.spec.seats);
+                result = Hold{seat, token};
+                return true;
+            }
+        }
+    }
+    
+    // Бронирует конкретное место на карте
+    bool holdSeat(size_t seat, Hold &result) {
+        if (seat >= totalSeats) return false;
+        ClassState &cls = classes[seatClass[seat]];
+        uint64_t token = makeToken();
+        if (takeRemaining(cls.remaining)) {
+            uint64_t expected = 0;
+            if (seatState[seat].compare_exchange_strong(expected, token)) {
+                result = Hold{seat, token};
+                return true;
+            }
+            cls.remaining++;
+        }
+        if (reclaimExpired(seat, token)) {
+            result = Hold{seat, token};
+            return true;
+        }
+        return false;
+    }
+    
+    // Оплата брони: выпускает билет, если бронь еще действует
+    optional<Ticket> confirm(const Hold &h) {
+        if (h.seat >= totalSeats || (h.token >> SEQUENCE_BITS) <= nowMs()) return nullopt;
+        uint64_t expected = h.token;
+        if (!seatState[h.seat].compare_exchange_strong(expected, SOLD)) return nullopt;
+        unsigned long number = nextTicketNumber.fetch_add(1);
+        seatTicket[h.seat] = number;
+        return Ticket(number, classes[seatClass[h.seat]].spec.price);
+    }
+    
+    void release(const Hold &h) {
+        if (h.seat < totalSeats) freeSeat(h.seat, h.token);
+    }
+    
+    // Снимает просроченные брони, возвращает число освобожденных мест
+    size_t releaseExpired() {
+        uint64_t now = nowMs();
+        size_t released = 0;
+        for (size_t seat = 0; seat < totalSeats; ++seat) {
+            uint64_t state = seatState[seat].load();
+            if (state != 0 && state != SOLD && (state >> SEQUENCE_BITS) <= now && freeSeat(seat, state)) {
+                released++;
+            }
+        }
+        return released;
+    }
+    
+    long getRemaining(size_t classIndex) const {
+        return classIndex < classes.size() ? classes[classIndex].remaining.load() : 0;
+    }
+    
+    size_t getSoldCount() const {
+        size_t sold = 0;
+        for (size_t seat = 0; seat < totalSeats; ++seat) {
+            if (seatState[seat].load() == SOLD) sold++;
+        }
+        return sold;
+    }
+    
+    // Номера проданных билетов (0 - место не продано)
+    vector<unsigned long> getTicketNumbers() const {
+        vector<unsigned long> numbers;
+        for (size_t seat = 0; seat < totalSeats; ++seat) {
+            if (seatState[seat].load() == SOLD) numbers.push_back(seatTicket[seat].load());
+        }
+        return numbers;
+    }
+    
+    string getSeatLabel(size_t seat) const {
+        const ClassState &cls = classes[seatClass[seat]];
+        return cls.spec.name + "-" + to_string(seat - cls.firstSeat + 1);
+    }
+    
+    size_t getTotalSeats() const { return totalSeats; };
+    size_t getClassCount() const { return classes.size(); };
+    const Event &getEvent() const { return event; };
+};
+
+// Номера билетов уникальны в пределах процесса для всех событий
+atomic<unsigned long> TicketSales::nextTicketNumber{100000001};
+
+static inline uint64_t mixHash(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Фильтр Блума для офлайн-сканеров: "нет" - билет точно не выпускался,
+// "да" - выпускался с вероятностью ошибки около 1% при 10 битах на билет
+class BloomFilter {
+protected:
+    vector<uint64_t> bits;
+    uint64_t bitCount;
+    int hashes;
+public:
+    BloomFilter(size_t expected, int bitsPerKey = 10)
+        : bitCount(max<uint64_t>(64, (uint64_t)expected * bitsPerKey)),
+          hashes(max(1, (int)(bitsPerKey * 0.69))) {
+        bits.assign((bitCount + 63) / 64, 0);
+    }
+    virtual ~BloomFilter() {};
+    void add(unsigned long key) {
+        uint64_t h = mixHash(key);
+        uint64_t step = (h >> 33) | 1;
+        for (int i = 0; i < hashes; ++i, h += step) {
+            uint64_t bit = h % bitCount;
+            bits[bit / 64] |= 1ULL << (bit % 64);
+        }
+    }
+    bool mightContain(unsigned long key) const {
+        uint64_t h = mixHash(key);
+        uint64_t step = (h >> 33) | 1;
+        for (int i = 0; i < hashes; ++i, h += step) {
+            uint64_t bit = h % bitCount;
+            if (!(bits[bit / 64] >> (bit % 64) & 1)) return false;
+        }
+        return true;
+    }
+    size_t sizeInBytes() const { return bits.size() * sizeof(uint64_t); };
+};
+
+enum class CheckInResult { Admitted, AlreadyUsed, Unknown };
+
+// Индекс выпущенных билетов для входа: хэш-множество с открытой адресацией строится один раз,
+// отметка о проходе - отдельный атомарный бит на слот. Повторный проход по тому же билету
+// через любой турникет видит уже установленный бит.
+class CheckInIndex {
+protected:
+    vector<unsigned long> slots;              // 0 - пустой слот
+    unique_ptr<atomic<uint64_t>[]> usedBits;
+    size_t mask;
+    size_t ticketCount = 0;
+    BloomFilter bloom;
+
+    size_t find(unsigned long number) const {
+        if (number == 0) return SIZE_MAX;
+        size_t slot = mixHash(number) & mask;
+        while (slots[slot] != 0) {
+            if (slots[slot] == number) return slot;
+            slot = (slot + 1) & mask;
+        }
+        return SIZE_MAX;
+    }
+public:
+    CheckInIndex(const vector<unsigned long> &issued) : bloom(issued.size()) {
+        size_t capacity = 16;
+        while (capacity < issued.size() * 2) capacity <<= 1;
+        slots.assign(capacity, 0);
+        mask = capacity - 1;
+        for (unsigned long number : issued) {
+            if (number == 0) continue;
+            size_t slot = mixHash(number) & mask;
+            while (slots[slot] != 0 && slots[slot] != number) slot = (slot + 1) & mask;
+            if (slots[slot] == 0) {
+                slots[slot] = number;
+                ticketCount++;
+                bloom.add(number);
+            }
+        }
+        size_t words = capacity / 64 + 1;
+        usedBits.reset(new atomic<uint64_t>[words]);
+        for (size_t i = 0; i < words; ++i) usedBits[i] = 0;
+    }
+    virtual ~CheckInIndex() {};
+
+    bool isIssued(unsigned long number) const { return find(number) != SIZE_MAX; };
+
+    CheckInResult checkIn(unsigned long number) {
+        size_t slot = find(number);
+        if (slot == SIZE_MAX) return CheckInResult::Unknown;
+        uint64_t bit = 1ULL << (slot % 64);
+        uint64_t before = usedBits[slot / 64].fetch_or(bit);
+        return (before & bit) ? CheckInResult::AlreadyUsed : CheckInResult::Admitted;
+    }
+
+    bool isUsed(unsigned long number) const {
+        size_t slot = find(number);
+        return slot != SIZE_MAX && (usedBits[slot / 64].load() >> (slot % 64) & 1);
+    }
+
+    // Копия фильтра для сканеров без связи с сервером
+    const BloomFilter &getBloomFilter() const { return bloom; };
+    size_t getTicketCount() const { return ticketCount; };
+    size_t sizeInBytes() const { return slots.size() * sizeof(unsigned long) + (slots.size() / 64 + 1) * 8; };
+};
+
+// Офлайн-сканер: проверяет билеты по фильтру Блума и запоминает пропущенных,
+// чтобы не пустить повторно через этот же вход; при восстановлении связи
+// отметки переносятся в общий индекс
+class OfflineScanner {
+protected:
+    BloomFilter bloom;
+    vector<unsigned long> admitted;
+    unordered_set<unsigned long> seen;
+public:
+    OfflineScanner(const BloomFilter &bf) : bloom(bf) {}
+    virtual ~OfflineScanner() {};
+    CheckInResult scan(unsigned long number) {
+        if (!bloom.mightContain(number)) return CheckInResult::Unknown;
+        if (!seen.insert(number).second) return CheckInResult::AlreadyUsed;
+        admitted.push_back(number);
+        return CheckInResult::Admitted;
+    }
+    // Возвращает билеты, прошедшие офлайн, но уже отмеченные в индексе (или не выпущенные)
+    vector<unsigned long> sync(CheckInIndex &index) {
+        vector<unsigned long> conflicts;
+        for (unsigned long number : admitted) {
+            if (index.checkIn(number) != CheckInResult::Admitted) conflicts.push_back(number);
+        }
+        admitted.clear();
+        return conflicts;
+    }
+};
+
+// Дата "YYYY-MM-DD" в днях от 1970-01-01; -1 при ошибке формата
+static long parseDate(const string &date) {
+    int y, m, d;
+    if (sscanf(date.c_str(), "%d-%d-%d", &y, &m, &d) != 3 || m < 1 || m > 12 || d < 1 || d > 31) return -1;
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// Время "10:00 AM" / "06:00 PM" / "18:30" в минутах от полуночи; -1 при ошибке формата
+static int parseClockTime(const string &time) {
+    int h, m;
+    char suffix[3] = {0};
+    int fields = sscanf(time.c_str(), "%d:%d %2s", &h, &m, suffix);
+    if (fields < 2 || m < 0 || m > 59) return -1;
+    if (fields == 3) {
+        char p = (char)toupper(suffix[0]);
+        if (h < 1 || h > 12 || (p != 'A' && p != 'P')) return -1;
+        h = h % 12 + (p == 'P' ? 12 : 0);
+    }
+    return (h >= 0 && h < 24) ? h * 60 + m : -1;
+}
+
+// Полуоткрытый интервал [start, end) в минутах от 1970-01-01
+struct TimeWindow {
+    long long start;
+    long long end;
+};
+
+// Окно проведения события: дата события плюс время по расписанию.
+// Окончание не позже начала означает переход через полночь.
+static optional<TimeWindow> makeWindow(const string &date, const Schedule &schedule) {
+    long day = parseDate(date);
+    int from = parseClockTime(schedule.getStartTime());
+    int to = parseClockTime(schedule.getEndTime());
+    if (day < 0 || from < 0 || to < 0) return nullopt;
+    long long start = (long long)day * 1440 + from;
+    long long end = (long long)day * 1440 + to + (to <= from ? 1440 : 0);
+    return TimeWindow{start, end};
+}
+
+// Дерево интервалов: декартово дерево по началу интервала, в каждом узле - максимальный
+// конец в поддереве. Поиск пересечения спускается только в ту ветвь, где оно возможно,
+// поэтому вставка, удаление и проверка - O(log n) в среднем.
+class IntervalTree {
+protected:
+    struct Node {
+        TimeWindow window;
+        long long maxEnd;
+        size_t id;
+        uint32_t priority;
+        int left = -1;
+        int right = -1;
+    };
+    vector<Node> nodes;
+    vector<int> freeNodes;
+    int root = -1;
+    size_t count = 0;
+    mt19937 rng{12345};
+
+    bool less(int a, const TimeWindow &w, size_t id) const {
+        const Node &n = nodes[a];
+        return n.window.start < w.start || (n.window.start == w.start && n.id < id);
+    }
+    void update(int n) {
+        Node &node = nodes[n];
+        node.maxEnd = node.window.end;
+        if (node.left >= 0) node.maxEnd = max(node.maxEnd, nodes[node.left].maxEnd);
+        if (node.right >= 0) node.maxEnd = max(node.maxEnd, nodes[node.right].maxEnd);
+    }
+    // Делит дерево на ключи меньше (w.start, id) и остальные
+    void split(int n, const TimeWindow &w, size_t id, int &l, int &r) {
+        if (n < 0) {
+            l = r = -1;
+            return;
+        }
+        if (less(n, w, id)) {
+            split(nodes[n].right, w, id, nodes[n].right, r);
+            l = n;
+        } else {
+            split(nodes[n].left, w, id, l, nodes[n].left);
+            r = n;
+        }
+        update(n);
+    }
+    int merge(int l, int r) {
+        if (l < 0) return r;
+        if (r < 0) return l;
+        if (nodes[l].priority > nodes[r].priority) {
+            nodes[l].right = merge(nodes[l].right, r);
+            update(l);
+            return l;
+        }
+        nodes[r].left = merge(l, nodes[r].left);
+        update(r);
+        return r;
+    }
+public:
+    IntervalTree() {}
+    virtual ~IntervalTree() {};
+
+    void insert(const TimeWindow &w, size_t id) {
+        int n;
+        if (!freeNodes.empty()) {
+            n = freeNodes.back();
+            freeNodes.pop_back();
+            nodes[n] = Node{w, w.end, id, (uint32_t)rng()};
+        } else {
+            n = (int)nodes.size();
+            nodes.push_back(Node{w, w.end, id, (uint32_t)rng()});
+        }
+        int l, r;
+        split(root, w, id, l, r);
+        root = merge(merge(l, n), r);
+        count++;
+    }
+
+    bool erase(const TimeWindow &w, size_t id) {
+        int l, mid, r;
+        split(root, w, id, l, mid);
+        split(mid, TimeWindow{w.start, w.end}, id + 1, mid, r);
+        bool found = mid >= 0;
+        if (found) {
+            // Узел с ключом (start, id) единственный
+            freeNodes.push_back(mid);
+            count--;
+        }
+        root = merge(l, r);
+        return found;
+    }
+
+    // Любой интервал, пересекающийся с w
+    optional<size_t> findOverlap(const TimeWindow &w) const {
+        int n = root;
+        while (n >= 0) {
+            const Node &node = nodes[n];
+            if (node.maxEnd <= w.start) return nullopt;
+            // Если слева есть интервал, заканчивающийся после w.start, и он не пересекает w,
+            // то все правее начинаются еще позже - искать достаточно слева
+            if (node.left >= 0 && nodes[node.left].maxEnd > w.start) {
+                n = node.left;
+                continue;
+            }
+            if (node.window.start < w.end && node.window.end > w.start) return node.id;
+            if (node.window.start >= w.end) return nullopt;
+            n = node.right;
+        }
+        return nullopt;
+    }
+
+    size_t size() const { return count; };
+};
+
+// Календарь площадок: для каждой площадки - дерево интервалов ее бронирований.
+// Событие не может занять площадку, уже занятую в пересекающееся время.
+class VenueCalendar {
+public:
+    struct Booking {
+        string eventName;
+        size_t venueId;
+        TimeWindow window;
+        bool active;
+    };
+protected:
+    vector<string> venueNames;
+    unordered_map<string, size_t> venueIndex;
+    vector<IntervalTree> trees;
+    vector<Booking> bookings;
+    mutable shared_mutex mtx;
+public:
+    VenueCalendar() {}
+    virtual ~VenueCalendar() {};
+
+    size_t addVenue(const Venue &venue) {
+        unique_lock<shared_mutex> lock(mtx);
+        auto it = venueIndex.find(venue.getLocation());
+        if (it != venueIndex.end()) return it->second;
+        venueNames.push_back(venue.getLocation());
+        trees.emplace_back();
+        venueIndex[venue.getLocation()] = venueNames.size() - 1;
+        return venueNames.size() - 1;
+    }
+
+    // Бронирует площадку на окно; nullopt - площадка неизвестна или занята
+    optional<size_t> book(const string &eventName, const string &venue, const TimeWindow &window) {
+        if (window.end <= window.start) return nullopt;
+        unique_lock<shared_mutex> lock(mtx);
+        auto it = venueIndex.find(venue);
+        if (it == venueIndex.end()) return nullopt;
+        IntervalTree &tree = trees[it->second];
+        if (tree.findOverlap(window)) return nullopt;
+        size_t id = bookings.size();
+        bookings.push_back(Booking{eventName, it->second, window, true});
+        tree.insert(window, id);
+        return id;
+    }
+
+    // То же для события и расписания в исходном строковом виде
+    optional<size_t> book(const Event &event, const Schedule &schedule) {
+        auto window = makeWindow(event.getDate(), schedule);
+        if (!window) return nullopt;
+        return book(event.getName(), event.getVenue(), *window);
+    }
+
+    bool cancel(size_t bookingId) {
+        unique_lock<shared_mutex> lock(mtx);
+        if (bookingId >= bookings.size() || !bookings[bookingId].active) return false;
+        Booking &b = bookings[bookingId];
+        b.active = false;
+        return trees[b.venueId].erase(b.window, bookingId);
+    }
+
+    // Бронирование, с которым конфликтует окно на площадке
+    optional<size_t> findConflict(const string &venue, const TimeWindow &window) const {
+        shared_lock<shared_mutex> lock(mtx);
+        auto it = venueIndex.find(venue);
+        if (it == venueIndex.end()) return nullopt;
+        return trees[it->second].findOverlap(window);
+    }
+
+    // Площадки, свободные на всем окне
+    vector<string> freeVenues(const TimeWindow &window) const {
+        shared_lock<shared_mutex> lock(mtx);
+        vector<string> result;
+        for (size_t v = 0; v < trees.size(); ++v) {
+            if (!trees[v].findOverlap(window)) result.push_back(venueNames[v]);
+        }
+        return result;
+    }
+
+    // Копия бронирования, снятая под блокировкой: push_back в book() может переместить вектор
+    optional<Booking> getBooking(size_t bookingId) const {
+        shared_lock<shared_mutex> lock(mtx);
+        if (bookingId >= bookings.size()) return nullopt;
+        return bookings[bookingId];
+    }
+    size_t getVenueCount() const {
+        shared_lock<shared_mutex> lock(mtx);
+        return venueNames.size();
+    }
 };
 
 int main() {
@@ -96,9 +1141,14 @@ int main() {
     // Расписание
     Schedule schedule("10:00 AM", "06:00 PM");
 
+    // Реестр участников: отзыв ссылается на участника, а не копирует его имя
+    ParticipantRegistry registry;
+    ParticipantHandle aliceId = registry.add(alice).first;
+    ParticipantHandle bobId = registry.add(bob).first;
+
     // Сбор отзывов
-    Feedback feedbackA(alice.getFullName(), "Замечательное мероприятие!");
-    Feedback feedbackB(bob.getFullName(), "Всё прошло отлично.");
+    Feedback feedbackA(aliceId, "Замечательное мероприятие!");
+    Feedback feedbackB(bobId, "Всё прошло отлично.");
 
     // Отображение информации
     cout << "Мероприятие: " << event.getName() << ", Дата: " << event.getDate() << "\n";
@@ -111,7 +1161,275 @@ int main() {
 
     cout << "Участник #2: " << bob.getFullName() << ", Email: " << bob.getEmail() << "\n";
     cout << "Билет №" << ticketB.getTicketNumber() << ", Цена: $" << ticketB.getPrice() << "\n";
-    cout << "Отзыв: " << feedbackB.getComment() << "\n";
+    cout << "Отзыв: " << feedbackB.getComment() << "\n\n";
+
+    // Массовая регистрация из CSV: повтор адреса в другом регистре не создает нового участника
+    {
+        stringstream small("first_name,last_name,email\n"
+                           "Carol,White,carol@example.com\n"
+                           "\"Dan, Jr.\",Brown,dan@example.com\n"
+                           "Alice,Smith,  ALICE.Smith@Mail.ru \n"
+                           "Eve,,not-an-email\n");
+        auto stats = registry.importCsv(small);
+        cout << "Импорт: строк " << stats.rows << ", добавлено " << stats.added << ", повторов " << stats.duplicates
+             << ", ошибок " << stats.invalid << "; автор первого отзыва: " << registry.getFullName(feedbackA.getParticipant())
+             << " <" << registry.getEmail(feedbackA.getParticipant()) << ">\n";
+
+        // Нагрузка: 200 тысяч строк, каждая десятая - повтор уже зарегистрированного адреса
+        const int rows = 200000;
+        string csv = "first_name,last_name,email\n";
+        csv.reserve(rows * 48);
+        mt19937 rng(42);
+        static const char *firstNames[] = {"Anna", "Ivan", "Maria", "Oleg", "Elena", "Petr", "Olga", "Sergey"};
+        static const char *lastNames[] = {"Ivanova", "Petrov", "Sidorova", "Smirnov", "Kuznetsova", "Popov"};
+        for (int i = 0; i < rows; ++i) {
+            int person = (i % 10 == 9) ? (int)(rng() % (i + 1)) : i;
+            const char *fn = firstNames[person % 8];
+            const char *ln = lastNames[person % 6];
+            csv.append(fn).append(",").append(ln).append(",");
+            csv.append(i % 10 == 9 ? " " : "").append(fn).append(".").append(to_string(person));
+            csv.append(person % 3 ? "@mail.ru\n" : "@GMAIL.com\n");
+        }
+        stringstream bulk(move(csv));
+        ParticipantRegistry conference;
+        auto start = chrono::steady_clock::now();
+        auto bulkStats = conference.importCsv(bulk);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "Массовый импорт: " << bulkStats.rows << " строк за " << ms << " мс ("
+             << (size_t)(bulkStats.rows / ms * 1000) << " строк/с), участников " << conference.size()
+             << ", повторов " << bulkStats.duplicates << ", строки в арене " << conference.arenaBytes() / 1024 << " КБ\n\n";
+    }
+
+    // Аналитика отзывов: частые слова и тональность по событиям
+    {
+        FeedbackAnalytics analytics;
+        vector<FeedbackBatch> small{{event.getName(), {feedbackA, feedbackB,
+            Feedback(aliceId, "Доклады не понравились, в зале было душно."),
+            Feedback(bobId, "Great talks, but the coffee line was terrible.")}}};
+        auto result = analytics.analyze(small);
+        const auto &summary = result.events[0];
+        cout << "Отзывы о \"" << summary.eventName << "\": " << summary.comments << ", положительных " << summary.positive
+             << ", отрицательных " << summary.negative << ", средняя оценка " << summary.averageScore() << "\n";
+
+        // Нагрузка: 60 тысяч отзывов о 20 событиях на двух языках
+        static const char *fragments[] = {
+            "Отличная организация, доклады очень интересные.", "Было скучно и душно, кофе холодный.",
+            "Спасибо спикерам! Всё понравилось.", "Не понравилась очередь на регистрацию.",
+            "Прекрасная площадка, удобная навигация.", "Great speakers and excellent networking.",
+            "The keynote was boring and started late.", "Useful workshops, thank you!",
+            "Not good: crowded halls, terrible Wi-Fi.", "Ёмкие доклады, хорошие вопросы из зала."};
+        const size_t fragmentCount = sizeof(fragments) / sizeof(fragments[0]);
+        mt19937 rng(43);
+        vector<FeedbackBatch> batches(20);
+        for (size_t e = 0; e < batches.size(); ++e) {
+            batches[e].eventName = "Событие " + to_string(e + 1);
+        }
+        for (int i = 0; i < 60000; ++i) {
+            string text = fragments[rng() % fragmentCount];
+            text.append(" ").append(fragments[rng() % fragmentCount]);
+            batches[rng() % batches.size()].comments.emplace_back(ParticipantHandle{(uint32_t)i}, text);
+        }
+        auto serial = FeedbackAnalytics(1).analyze(batches);
+        auto parallel = FeedbackAnalytics(8).analyze(batches);
+        bool same = serial.tokens == parallel.tokens;
+        for (size_t e = 0; e < batches.size(); ++e) {
+            same = same && serial.events[e].terms == parallel.events[e].terms && serial.events[e].score == parallel.events[e].score;
+        }
+        cout << "Аналитика: " << parallel.bytes / 1024 / 1024 << " МБ текста, " << parallel.tokens << " слов; 1 поток "
+             << serial.megabytesPerSecond() << " МБ/с, 8 потоков " << parallel.megabytesPerSecond()
+             << " МБ/с, результаты " << (same ? "совпадают" : "РАСХОДЯТСЯ") << "\n";
+        cout << "Событие 1: оценка " << parallel.events[0].averageScore() << ", частые слова:";
+        for (const auto &term : parallel.events[0].topTerms(5)) {
+            cout << " " << term.first << "(" << term.second << ")";
+        }
+        cout << "\n\n";
+    }
+
+    // Календарь площадок: второе событие в тот же зал в пересекающееся время отклоняется
+    VenueCalendar calendar;
+    calendar.addVenue(venue);
+    calendar.addVenue(Venue("Москва, Малый зал", 1000));
+    Event workshop("Воркшоп ITPro", "2025-10-15", "Москва, Концерт-холл");
+    auto first = calendar.book(event, schedule);
+    auto second = calendar.book(workshop, Schedule("05:00 PM", "08:00 PM"));
+    cout << "Бронирование зала для \"" << event.getName() << "\": " << (first ? "подтверждено" : "отклонено")
+         << ", для \"" << workshop.getName() << "\": " << (second ? "подтверждено" : "конфликт") << "\n";
+    if (auto window = makeWindow("2025-10-15", Schedule("05:00 PM", "08:00 PM"))) {
+        cout << "Свободно 2025-10-15 с 17:00 до 20:00:";
+        for (const auto &name : calendar.freeVenues(*window)) {
+            cout << " " << name;
+        }
+        cout << "\n";
+    }
+    if (first && calendar.cancel(*first)) {
+        auto retry = calendar.book(workshop, Schedule("05:00 PM", "08:00 PM"));
+        cout << "После отмены \"" << event.getName() << "\" воркшоп " << (retry ? "забронирован" : "не забронирован") << "\n\n";
+    }
+
+    // Нагрузка: 200 площадок, пять лет событий, сверка с полным перебором на выборке
+    {
+        VenueCalendar big;
+        const int venueCount = 200;
+        vector<string> names;
+        for (int v = 0; v < venueCount; ++v) {
+            names.push_back("Площадка " + to_string(v));
+            big.addVenue(Venue(names.back(), 500));
+        }
+        const long firstDay = parseDate("2025-01-01");
+        const int attempts = 150000;
+        mt19937 rng(41);
+        vector<vector<TimeWindow>> accepted(venueCount);
+        int booked = 0;
+        auto bookStart = chrono::steady_clock::now();
+        for (int i = 0; i < attempts; ++i) {
+            int v = (int)(rng() % venueCount);
+            long long day = firstDay + (long long)(rng() % (5 * 365));
+            long long from = day * 1440 + 6 * 60 + (long long)(rng() % 64) * 15;
+            TimeWindow w{from, from + 60 + (long long)(rng() % 8) * 30};
+            if (big.book("Событие " + to_string(i), names[v], w)) {
+                accepted[v].push_back(w);
+                booked++;
+            }
+        }
+        double bookNs = chrono::duration<double, nano>(chrono::steady_clock::now() - bookStart).count() / attempts;
+
+        const int queries = 1000;
+        int mismatches = 0;
+        size_t freeTotal = 0;
+        auto queryStart = chrono::steady_clock::now();
+        for (int q = 0; q < queries; ++q) {
+            long long from = (firstDay + (long long)(rng() % (5 * 365))) * 1440 + 9 * 60;
+            TimeWindow w{from, from + 180};
+            vector<string> free = big.freeVenues(w);
+            freeTotal += free.size();
+            if (q % 20 == 0) {
+                size_t expected = 0;
+                for (const auto &list : accepted) {
+                    bool busy = false;
+                    for (const auto &b : list) {
+                        busy = busy || (b.start < w.end && b.end > w.start);
+                    }
+                    expected += !busy;
+                }
+                mismatches += expected != free.size();
+            }
+        }
+        double queryUs = chrono::duration<double, micro>(chrono::steady_clock::now() - queryStart).count() / queries;
+        cout << "Календарь: " << booked << " из " << attempts << " событий на " << venueCount
+             << " площадках за 5 лет, " << bookNs << " нс на проверку с бронированием; поиск свободных площадок "
+             << queryUs << " мкс (в среднем " << freeTotal / queries << " свободно), расхождений с перебором: "
+             << mismatches << "\n\n";
+    }
+
+    // Продажа билетов с контролем вместимости: 100 тысяч покупателей на 1000 мест
+    Venue hall("Москва, Малый зал", 1000);
+    TicketSales sales(event, hall, {{"Партер", 700.0, 200}, {"Амфитеатр", 500.0, 500}, {"Балкон", 300.0, 500}},
+                      chrono::milliseconds(20));
+    const int workers = 16;
+    atomic<long> abandoned{0}, soldOut{0};
+    auto runWave = [&](int buyers, int abandonRate) {
+        atomic<int> nextBuyer{0};
+        vector<thread> checkout;
+        for (int w = 0; w < workers; ++w) {
+            checkout.emplace_back([&, w]() {
+                mt19937 rng(w + buyers);
+                while (nextBuyer.fetch_add(1) < buyers) {
+                    TicketSales::Hold h;
+                    if (!sales.hold(rng() % sales.getClassCount(), h)) {
+                        soldOut++;
+                        continue;
+                    }
+                    // Часть покупателей бросает оформление, их бронь истечет сама
+                    if (abandonRate > 0 && (int)(rng() % 100) < abandonRate) {
+                        abandoned++;
+                        continue;
+                    }
+                    sales.confirm(h);
+                }
+            });
+        }
+        for (auto &t : checkout) {
+            t.join();
+        }
+    };
+    auto salesStart = chrono::steady_clock::now();
+    runWave(100000, 10);
+    auto salesMs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - salesStart).count();
+    size_t firstWave = sales.getSoldCount();
+    // После истечения броней места выкупает лист ожидания: hold перехватывает просроченные брони сам,
+    // releaseExpired снимает только те, что никто не перехватил
+    this_thread::sleep_for(chrono::milliseconds(25));
+    runWave(10000, 0);
+    size_t released = sales.releaseExpired();
+
+    vector<unsigned long> numbers = sales.getTicketNumbers();
+    unordered_set<unsigned long> unique(numbers.begin(), numbers.end());
+    cout << "Продажа: 100000 покупателей на " << hall.getCapacity() << " мест, продано " << firstWave << " за "
+         << salesMs << " мс, брошено броней " << abandoned << ", снято просроченных " << released
+         << "; после листа ожидания продано " << sales.getSoldCount() << ", отказов (нет мест) " << soldOut
+         << ", уникальных номеров билетов " << unique.size() << "\n";
+    for (size_t c = 0; c < sales.getClassCount(); ++c) {
+        cout << "Осталось мест класса " << c << ": " << sales.getRemaining(c) << "\n";
+    }
+
+    // Проход на событие: повторный билет не пропускается ни на одном турникете
+    CheckInIndex doors(numbers);
+    cout << "Проход по билету " << numbers[0] << ": "
+         << (doors.checkIn(numbers[0]) == CheckInResult::Admitted ? "пропущен" : "отказ") << ", повторно: "
+         << (doors.checkIn(numbers[0]) == CheckInResult::AlreadyUsed ? "уже использован" : "ошибка") << "\n";
+
+    // Нагрузка: миллион билетов, 8 турникетов, каждый билет предъявляют дважды на разных входах
+    {
+        const size_t ticketCount = 1000000;
+        vector<unsigned long> issued;
+        issued.reserve(ticketCount);
+        mt19937_64 rng(40);
+        unordered_set<unsigned long> distinct;
+        while (issued.size() < ticketCount) {
+            unsigned long number = (unsigned long)(rng() % 4000000000UL) + 1;
+            if (distinct.insert(number).second) issued.push_back(number);
+        }
+        auto buildStart = chrono::steady_clock::now();
+        CheckInIndex index(issued);
+        auto buildMs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - buildStart).count();
+
+        const int gates = 8;
+        atomic<long> admitted{0}, rejected{0};
+        auto gateStart = chrono::steady_clock::now();
+        vector<thread> turnstiles;
+        for (int g = 0; g < gates; ++g) {
+            turnstiles.emplace_back([&, g]() {
+                long ok = 0, dup = 0;
+                // Вход g обслуживает свою долю билетов и долю соседнего входа
+                for (int pass = 0; pass < 2; ++pass) {
+                    size_t share = (g + pass) % gates;
+                    for (size_t i = share; i < issued.size(); i += gates) {
+                        if (index.checkIn(issued[i]) == CheckInResult::Admitted) ok++;
+                        else dup++;
+                    }
+                }
+                admitted += ok;
+                rejected += dup;
+            });
+        }
+        for (auto &t : turnstiles) {
+            t.join();
+        }
+        double gateNs = chrono::duration<double, nano>(chrono::steady_clock::now() - gateStart).count() / (2.0 * ticketCount);
+
+        OfflineScanner scanner(index.getBloomFilter());
+        size_t falsePositives = 0;
+        const int probes = 100000;
+        for (int i = 0; i < probes; ++i) {
+            unsigned long fake = (unsigned long)(rng() % 4000000000UL) + 1;
+            if (!distinct.count(fake) && scanner.scan(fake) == CheckInResult::Admitted) falsePositives++;
+        }
+        cout << "Проход: " << index.getTicketCount() << " билетов, индекс " << index.sizeInBytes() / 1024
+             << " КБ построен за " << buildMs << " мс; " << gates << " турникетов: пропущено " << admitted
+             << ", повторов отклонено " << rejected << ", " << gateNs << " нс на проверку\n";
+        cout << "Фильтр Блума: " << index.getBloomFilter().sizeInBytes() / 1024 << " КБ, ложных срабатываний "
+             << falsePositives * 100.0 / probes << "%, конфликтов при синхронизации " << scanner.sync(index).size() << "\n";
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -2,6 +2,34 @@
 #include <vector>
 #include <string>
 #include <iomanip>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <cmath>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <climits>
+#include <filesystem>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -9,12 +37,333 @@ class Currency {
 protected:
     string code;
     double exchangeRate;
+    int id = -1;   // номер в CurrencyConverter
 public:
     Currency(const string &c, double exchR)
         : code(c), exchangeRate(exchR) {}
     virtual ~Currency() {};
     string getCode() const { return code; };
     double getExchangeRate() const { return exchangeRate; };
+    int getId() const { return id; };
+    void setId(int i) { id = i; };
+};
+
+// Неизменяемая таблица курсов: курс каждой валюты к базовой и матрица кросс-курсов.
+// Матрица хранится по столбцам (по валюте назначения), чтобы пакетный пересчет
+// в одну валюту читал один непрерывный столбец.
+class RateTable {
+protected:
+    uint64_t version;
+    long long asOf;          // секунды Unix
+    vector<double> rates;    // единиц валюты за единицу базовой
+    vector<double> matrix;   // matrix[to * count + from]
+public:
+    RateTable(uint64_t ver, long long when, const vector<double> &r)
+        : version(ver), asOf(when), rates(r), matrix(r.size() * r.size()) {
+        size_t n = rates.size();
+        for (size_t to = 0; to < n; ++to) {
+            for (size_t from = 0; from < n; ++from) {
+                matrix[to * n + from] = rates[to] / rates[from];
+            }
+        }
+    }
+    virtual ~RateTable() {};
+    uint64_t getVersion() const { return version; };
+    long long getAsOf() const { return asOf; };
+    size_t size() const { return rates.size(); };
+    double baseRate(int id) const { return rates[id]; };
+    double rate(int from, int to) const { return matrix[(size_t)to * rates.size() + from]; };
+    double convert(double amount, int from, int to) const { return from == to ? amount : amount * rate(from, to); };
+    // Множители пересчета всех валют в валюту to
+    const double *column(int to) const { return matrix.data() + (size_t)to * rates.size(); };
+    const vector<double> &getRates() const { return rates; };
+};
+
+// Сервис курсов: периодически перечитывает файл с курсами и публикует новую таблицу
+// подменой атомарного указателя (в стиле RCU). Читатели не берут блокировок: они
+// отмечаются в счетчике текущей эпохи, а писатель освобождает вытесненные из истории
+// таблицы только после того, как счетчик прошлой эпохи обнулится. Для многошаговых
+// отчетов снимок можно закрепить (pin) - он останется жить, пока на него есть ссылка.
+class RateService {
+public:
+    typedef shared_ptr<const RateTable> Snapshot;
+protected:
+    struct alignas(64) ReaderCount {
+        atomic<long> value{0};
+    };
+
+    vector<string> codes;
+    atomic<const RateTable*> current{nullptr};
+    atomic<unsigned> epoch{0};
+    mutable ReaderCount readers[2];
+    mutable mutex historyMutex;      // только писатель и запросы к истории
+    deque<Snapshot> history;         // по возрастанию версии и времени
+    size_t maxHistory;
+    atomic<unsigned long> reloadCount{0};
+    atomic<unsigned long> rejectedCount{0};
+
+    thread poller;
+    mutex pollMutex;
+    condition_variable pollCondition;
+    bool stopping = false;
+    size_t lastFeedHash = 0;
+
+    // Ждет, пока завершатся все чтения, начатые до вызова. Вызывается под historyMutex.
+    void synchronize() {
+        unsigned e = epoch.fetch_add(1);
+        while (readers[e & 1].value.load() != 0) {
+            this_thread::yield();
+        }
+    }
+
+    void publish(Snapshot table) {
+        vector<Snapshot> retired;
+        lock_guard<mutex> lock(historyMutex);
+        history.push_back(table);
+        current.store(table.get());
+        while (history.size() > maxHistory) {
+            retired.push_back(move(history.front()));
+            history.pop_front();
+        }
+        if (!retired.empty()) synchronize();
+    }
+
+    static string trim(const string &s) {
+        size_t b = s.find_first_not_of(" \t\r");
+        size_t e = s.find_last_not_of(" \t\r");
+        return b == string::npos ? string() : s.substr(b, e - b + 1);
+    }
+public:
+    RateService(const vector<string> &currencyCodes, const vector<double> &initialRates, long long asOf, size_t historySize = 1024)
+        : codes(currencyCodes), maxHistory(max<size_t>(1, historySize)) {
+        readers[0].value = 0;
+        readers[1].value = 0;
+        publish(make_shared<const RateTable>(1, asOf, initialRates));
+    }
+    virtual ~RateService() {
+        stop();
+    };
+
+    // Выполняет f над текущей таблицей без блокировок
+    template <typename F>
+    auto read(F f) const -> decltype(f(declval<const RateTable&>())) {
+        unsigned e;
+        for (;;) {
+            e = epoch.load();
+            readers[e & 1].value.fetch_add(1);
+            if (epoch.load() == e) break;
+            readers[e & 1].value.fetch_sub(1);
+        }
+        struct Exit {
+            atomic<long> &count;
+            ~Exit() { count.fetch_sub(1); }
+        } exit{readers[e & 1].value};
+        return f(*current.load());
+    }
+
+    double convert(double amount, int from, int to) const {
+        return read([&](const RateTable &t) { return t.convert(amount, from, to); });
+    }
+
+    // Закрепленный снимок текущих курсов
+    Snapshot pin() const {
+        lock_guard<mutex> lock(historyMutex);
+        return history.back();
+    }
+
+    // Курсы, действовавшие на момент when; nullptr - история до этого момента не хранится
+    Snapshot asOf(long long when) const {
+        lock_guard<mutex> lock(historyMutex);
+        auto it = upper_bound(history.begin(), history.end(), when,
+                              [](long long t, const Snapshot &s) { return t < s->getAsOf(); });
+        if (it == history.begin()) return nullptr;
+        return *(it - 1);
+    }
+
+    // Разбирает ленту курсов: строки "КОД КУРС" или "КОД,КУРС" и необязательная "# asof <секунды>".
+    // Валюты, которых нет в ленте, сохраняют прежний курс. Некорректная лента не публикуется.
+    bool reload(istream &in) {
+        Snapshot last = pin();
+        vector<double> rates = last->getRates();
+        long long when = chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+        string line;
+        while (getline(in, line)) {
+            line = trim(line);
+            if (line.empty()) continue;
+            if (line[0] == '#') {
+                long long t;
+                if (sscanf(line.c_str(), "# asof %lld", &t) == 1) when = t;
+                continue;
+            }
+            replace(line.begin(), line.end(), ',', ' ');
+            char code[16];
+            double value;
+            if (sscanf(line.c_str(), "%15s %lf", code, &value) != 2 || !(value > 0) || !isfinite(value)) {
+                rejectedCount++;
+                return false;
+            }
+            auto it = find(codes.begin(), codes.end(), code);
+            if (it != codes.end()) rates[it - codes.begin()] = value;
+        }
+        if (when < last->getAsOf()) {
+            rejectedCount++;
+            return false;
+        }
+        publish(make_shared<const RateTable>(last->getVersion() + 1, when, rates));
+        reloadCount++;
+        return true;
+    }
+
+    bool reloadFromFile(const string &path) {
+        ifstream in(path);
+        if (!in) return false;
+        stringstream content;
+        content << in.rdbuf();
+        string text = content.str();
+        size_t h = hash<string>()(text);
+        if (h == lastFeedHash) return false;
+        lastFeedHash = h;
+        stringstream feed(text);
+        return reload(feed);
+    }
+
+    // Фоновое обновление: файл перечитывается каждые interval, изменения публикуются
+    void start(const string &path, chrono::milliseconds interval) {
+        stop();
+        stopping = false;
+        poller = thread([this, path, interval]() {
+            unique_lock<mutex> lock(pollMutex);
+            while (!stopping) {
+                lock.unlock();
+                reloadFromFile(path);
+                lock.lock();
+                pollCondition.wait_for(lock, interval, [this]() { return stopping; });
+            }
+        });
+    }
+
+    void stop() {
+        {
+            lock_guard<mutex> lock(pollMutex);
+            stopping = true;
+        }
+        pollCondition.notify_all();
+        if (poller.joinable()) poller.join();
+    }
+
+    unsigned long getReloadCount() const { return reloadCount; };
+    unsigned long getRejectedCount() const { return rejectedCount; };
+    size_t getHistorySize() const {
+        lock_guard<mutex> lock(historyMutex);
+        return history.size();
+    }
+};
+
+// Конвертер валют: плотная матрица кросс-курсов по целым номерам валют.
+// exchangeRate валюты - сколько ее единиц дают за одну единицу базовой валюты,
+// поэтому курс from -> to равен rate(to) / rate(from). Если подключен сервис курсов,
+// пересчет идет по его текущей таблице, иначе - по курсам, заданным в Currency.
+class CurrencyConverter {
+protected:
+    vector<Currency*> currencies;
+    shared_ptr<const RateTable> table;
+    const RateService *live = nullptr;
+
+    template <typename F>
+    auto withTable(F f) const -> decltype(f(declval<const RateTable&>())) {
+        if (live) return live->read(f);
+        return f(*table);
+    }
+
+    // Закрепленная таблица для пакетной обработки
+    RateService::Snapshot snapshot() const { return live ? live->pin() : table; };
+public:
+    CurrencyConverter() {}
+    virtual ~CurrencyConverter() {};
+
+    // Регистрирует валюту и присваивает ей номер. Все валюты регистрируются до подключения сервиса курсов.
+    int addCurrency(Currency *currency) {
+        if (currency->getId() >= 0 && (size_t)currency->getId() < currencies.size() && currencies[currency->getId()] == currency) {
+            return currency->getId();
+        }
+        currency->setId((int)currencies.size());
+        currencies.push_back(currency);
+        table = make_shared<const RateTable>(0, 0, getRates());
+        return currency->getId();
+    }
+
+    void attachRates(const RateService *service) { live = service; };
+
+    Currency *findCurrency(const string &code) const {
+        for (auto c : currencies) {
+            if (c->getCode() == code) return c;
+        }
+        return nullptr;
+    }
+
+    vector<string> getCodes() const {
+        vector<string> codes;
+        for (auto c : currencies) {
+            codes.push_back(c->getCode());
+        }
+        return codes;
+    }
+    vector<double> getRates() const {
+        vector<double> rates;
+        for (auto c : currencies) {
+            rates.push_back(c->getExchangeRate());
+        }
+        return rates;
+    }
+
+    double rate(int from, int to) const {
+        return withTable([&](const RateTable &t) { return t.rate(from, to); });
+    }
+    double convert(double amount, int from, int to) const {
+        return from == to ? amount : withTable([&](const RateTable &t) { return t.convert(amount, from, to); });
+    }
+    double convert(double amount, const Currency *from, const Currency *to) const {
+        return convert(amount, from->getId(), to->getId());
+    }
+
+    // Пакетный пересчет в одну валюту: снимок курсов и его столбец берутся один раз,
+    // цикл без ветвлений по непрерывным массивам компилятор векторизует
+    void convertBatch(const double *__restrict amounts, const uint16_t *__restrict currencyIds, size_t n,
+                      int target, double *__restrict out) const {
+        RateService::Snapshot t = snapshot();
+        const double *__restrict factor = t->column(target);
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = amounts[i] * factor[currencyIds[i]];
+        }
+    }
+
+    // Сумма пакета в одной валюте: блоками через буфер на стеке. Пересчет блока и его сумма
+    // по четырем независимым аккумуляторам - два отдельных цикла, оба компилятор векторизует
+    double sumBatch(const double *__restrict amounts, const uint16_t *__restrict currencyIds, size_t n, int target) const {
+        static constexpr size_t BLOCK = 256;
+        RateService::Snapshot t = snapshot();
+        const double *__restrict column = t->column(target);
+        double s[4] = {0, 0, 0, 0};
+        double block[BLOCK];
+        for (size_t begin = 0; begin < n; begin += BLOCK) {
+            size_t m = min(BLOCK, n - begin);
+            for (size_t k = 0; k < m; ++k) {
+                block[k] = amounts[begin + k] * column[currencyIds[begin + k]];
+            }
+            size_t k = 0;
+            for (; k + 4 <= m; k += 4) {
+                for (size_t j = 0; j < 4; ++j) {
+                    s[j] += block[k + j];
+                }
+            }
+            for (; k < m; ++k) {
+                s[0] += block[k];
+            }
+        }
+        return (s[0] + s[1]) + (s[2] + s[3]);
+    }
+
+    size_t getCurrencyCount() const { return currencies.size(); };
 };
 
 class Transaction {
@@ -22,68 +371,800 @@ protected:
     double amount;
     string description;
     Currency *currency;
+    uint16_t category;      // номер категории бюджета, 0 - без категории
 public:
-    Transaction(double amnt, const string &desc, Currency *cur)
-        : amount(amnt), description(desc), currency(cur) {}
+    Transaction(double amnt, const string &desc, Currency *cur, uint16_t cat = 0)
+        : amount(amnt), description(desc), currency(cur), category(cat) {}
     virtual ~Transaction() {};
     double getAmount() const { return amount; };
     string getDescription() const { return description; };
     Currency* getCurrency() const { return currency; };
+    uint16_t getCategory() const { return category; };
+};
+
+// Сумма в минимальных единицах валюты (копейках, центах)
+static long long toMinor(double amount) { return llround(amount * 100.0); }
+static double fromMinor(long long minor) { return minor / 100.0; }
+
+static long long nowSeconds() {
+    return chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Номер месяца с января 1970 года для момента времени в секундах Unix
+static long long monthsSinceEpoch(long long seconds) {
+    long long z = (seconds >= 0 ? seconds : seconds - 86399) / 86400 + 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    long long doe = z - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    long long month = mp < 10 ? mp + 3 : mp - 9;
+    long long year = yoe + era * 400 + (month <= 2);
+    return (year - 1970) * 12 + (month - 1);
+}
+
+// Начало месяца с номером months (от января 1970) в секундах Unix
+static long long monthStartSeconds(long long months) {
+    long long y = 1970 + (months >= 0 ? months / 12 : (months - 11) / 12);
+    long long m = months - (y - 1970) * 12 + 1;
+    y -= m <= 2;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    long long yoe = y - era * 400;
+    long long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5;
+    long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return (era * 146097 + doe - 719468) * 86400;
+}
+
+enum class EntryType : uint8_t { Opening, Deposit, Withdrawal, TransferIn, TransferOut };
+enum class EntryStatus : uint8_t { Applied, Rejected };
+
+struct LedgerEntry {
+    long long amount;       // в валюте счета, со знаком
+    uint16_t currency;      // валюта исходной транзакции
+    uint16_t category;      // категория бюджета
+    long long timestamp;    // секунды Unix
+    EntryType type;
+    EntryStatus status;
+};
+
+// Журнал операций счета только на добавление. Данные хранятся по столбцам в сегментах
+// фиксированного размера; при заданном каталоге сегменты - отображенные в память файлы
+// и журнал переживает перезапуск. Каждые CHECKPOINT_INTERVAL записей запоминается сумма
+// проведенных операций до этой точки, поэтому остаток на дату и сумма за период -
+// двоичный поиск по времени, чтение контрольной точки и проход не длиннее интервала.
+// Отклоненные операции сохраняются, но в остаток не входят.
+class Ledger {
+public:
+    static constexpr size_t SEGMENT_ENTRIES = 1 << 16;
+    static constexpr size_t CHECKPOINT_INTERVAL = 1024;
+    static constexpr size_t npos = SIZE_MAX;
+    static_assert(SEGMENT_ENTRIES % CHECKPOINT_INTERVAL == 0, "checkpoint interval must divide segment size");
+protected:
+    static constexpr uint64_t MAGIC = 0x3130524744454c46ULL;
+    struct SegmentHeader {
+        uint64_t magic;
+        uint64_t capacity;
+        uint64_t count;
+        uint64_t reserved;
+    };
+    struct Segment {
+        char *base = nullptr;
+        bool mapped = false;
+        SegmentHeader *header = nullptr;
+        long long *amounts = nullptr;
+        long long *timestamps = nullptr;
+        uint16_t *currencies = nullptr;
+        uint16_t *categories = nullptr;
+        uint8_t *types = nullptr;
+        uint8_t *statuses = nullptr;
+    };
+
+    string directory;
+    vector<Segment> segments;
+    size_t count = 0;
+    vector<long long> checkpoints{0};   // checkpoints[k] - сумма проведенных записей [0, k * CHECKPOINT_INTERVAL)
+    long long total = 0;
+    long long lastTimestamp = LLONG_MIN;
+
+    static size_t segmentBytes() {
+        return sizeof(SegmentHeader) + SEGMENT_ENTRIES * (2 * sizeof(long long) + 2 * sizeof(uint16_t) + 2);
+    }
+    static void layout(Segment &s) {
+        s.header = (SegmentHeader*)s.base;
+        char *p = s.base + sizeof(SegmentHeader);
+        s.amounts = (long long*)p;
+        p += SEGMENT_ENTRIES * sizeof(long long);
+        s.timestamps = (long long*)p;
+        p += SEGMENT_ENTRIES * sizeof(long long);
+        s.currencies = (uint16_t*)p;
+        p += SEGMENT_ENTRIES * sizeof(uint16_t);
+        s.categories = (uint16_t*)p;
+        p += SEGMENT_ENTRIES * sizeof(uint16_t);
+        s.types = (uint8_t*)p;
+        p += SEGMENT_ENTRIES;
+        s.statuses = (uint8_t*)p;
+    }
+    string segmentPath(size_t index) const {
+        char name[32];
+        snprintf(name, sizeof(name), "/ledger-%06zu.seg", index);
+        return directory + name;
+    }
+
+    // Отображает файл сегмента; create - создать новый нужного размера. false - такого сегмента нет.
+    // Остальные ошибки - исключения: журнал на диске нельзя молча подменить пустым в памяти
+    bool mapSegment(size_t index, bool create, Segment &s) {
+        string path = segmentPath(index);
+#ifndef _WIN32
+        int fd = open(path.c_str(), create ? (O_RDWR | O_CREAT | O_EXCL) : O_RDWR, 0644);
+        if (fd < 0 && !create && errno == ENOENT) return false;
+        if (fd < 0) throw runtime_error("cannot open ledger segment " + path + ": " + strerror(errno));
+        struct stat st;
+        SegmentHeader header{};
+        if (!create && pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) && header.magic != MAGIC) {
+            // Чужой файл или сегмент другого формата: преобразований форматов нет, только явный отказ
+            close(fd);
+            char found[20], expected[20];
+            snprintf(found, sizeof(found), "%016llx", (unsigned long long)header.magic);
+            snprintf(expected, sizeof(expected), "%016llx", (unsigned long long)MAGIC);
+            throw runtime_error("unknown ledger segment magic 0x" + string(found) + " in " + path +
+                                " (expected 0x" + string(expected) + ")");
+        }
+        bool ok = create ? ftruncate(fd, (off_t)segmentBytes()) == 0
+                         : fstat(fd, &st) == 0 && (size_t)st.st_size == segmentBytes();
+        void *p = ok ? mmap(nullptr, segmentBytes(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (p == MAP_FAILED) throw runtime_error("cannot map ledger segment " + path + ": wrong size or mmap failed");
+        s.base = (char*)p;
+        s.mapped = true;
+        layout(s);
+        if (create) *s.header = SegmentHeader{MAGIC, SEGMENT_ENTRIES, 0, 0};
+        if (s.header->magic != MAGIC || s.header->capacity != SEGMENT_ENTRIES || s.header->count > SEGMENT_ENTRIES) {
+            munmap(s.base, segmentBytes());
+            throw runtime_error("unsupported ledger segment format in " + path);
+        }
+        return true;
+#else
+        (void)create;
+        (void)s;
+        throw runtime_error("ledger on disk is not supported on this platform: " + path);
+#endif
+    }
+
+    Segment &addSegment() {
+        Segment s;
+        if (!directory.empty()) {
+            mapSegment(segments.size(), true, s);
+        } else {
+            // Без каталога сегмент живет только в памяти
+            s.base = new char[segmentBytes()];
+            s.mapped = false;
+            layout(s);
+            *s.header = SegmentHeader{MAGIC, SEGMENT_ENTRIES, 0, 0};
+        }
+        segments.push_back(s);
+        return segments.back();
+    }
+
+    long long appliedAt(size_t i) const {
+        const Segment &s = segments[i / SEGMENT_ENTRIES];
+        size_t k = i % SEGMENT_ENTRIES;
+        return s.statuses[k] == (uint8_t)EntryStatus::Applied ? s.amounts[k] : 0;
+    }
+
+    // Сумма проведенных записей [0, index)
+    long long prefix(size_t index) const {
+        size_t k = index / CHECKPOINT_INTERVAL;
+        long long sum = checkpoints[k];
+        size_t first = k * CHECKPOINT_INTERVAL;
+        if (first == index) return sum;
+        // Интервал контрольных точек делит размер сегмента, поэтому проход не выходит за сегмент
+        const Segment &s = segments[first / SEGMENT_ENTRIES];
+        const long long *amounts = s.amounts;
+        const uint8_t *statuses = s.statuses;
+        for (size_t i = first % SEGMENT_ENTRIES, end = i + (index - first); i < end; ++i) {
+            sum += statuses[i] == (uint8_t)EntryStatus::Applied ? amounts[i] : 0;
+        }
+        return sum;
+    }
+
+    // Первая запись со временем не раньше t
+    size_t lowerIndex(long long t) const {
+        size_t lo = 0, hi = count;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (timestampAt(mid) < t) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    void account(size_t i) {
+        total += appliedAt(i);
+        lastTimestamp = timestampAt(i);
+        if ((i + 1) % CHECKPOINT_INTERVAL == 0) checkpoints.push_back(total);
+    }
+
+    void releaseSegments() {
+        for (auto &s : segments) {
+#ifndef _WIN32
+            if (s.mapped) {
+                munmap(s.base, segmentBytes());
+                continue;
+            }
+#endif
+            delete[] s.base;
+        }
+        segments.clear();
+    }
+public:
+    // Пустой каталог - журнал в памяти; иначе существующие сегменты открываются и продолжаются
+    // (сегменты прежнего формата переводятся в текущий). Сегмент, который не удалось открыть
+    // или создать, - исключение runtime_error
+    Ledger(const string &dir = "") : directory(dir) {
+        try {
+            for (size_t index = 0; !directory.empty(); ++index) {
+                Segment s;
+                if (!mapSegment(index, false, s)) break;
+                segments.push_back(s);
+                size_t n = s.header->count;
+                for (size_t k = 0; k < n; ++k) {
+                    account(count++);
+                }
+                if (n < SEGMENT_ENTRIES) break;
+            }
+        } catch (...) {
+            releaseSegments();
+            throw;
+        }
+    }
+    Ledger(const Ledger&) = delete;
+    Ledger &operator=(const Ledger&) = delete;
+    virtual ~Ledger() {
+        releaseSegments();
+    };
+
+    // Добавляет запись и возвращает ее номер. Журнал упорядочен по времени (на этом стоят запросы
+    // по периодам), поэтому запись раньше последней не добавляется: возвращается npos
+    size_t append(long long amount, uint16_t currency, long long timestamp, EntryType type, EntryStatus status,
+                  uint16_t category = 0) {
+        if (timestamp < lastTimestamp) return npos;
+        if (count == segments.size() * SEGMENT_ENTRIES) addSegment();
+        Segment &s = segments.back();
+        size_t k = count % SEGMENT_ENTRIES;
+        s.amounts[k] = amount;
+        s.timestamps[k] = timestamp;
+        s.currencies[k] = currency;
+        s.categories[k] = category;
+        s.types[k] = (uint8_t)type;
+        s.statuses[k] = (uint8_t)status;
+        // Счетчик записей в заголовке обновляется последним: после сбоя видна только целая запись
+        s.header->count = k + 1;
+        account(count);
+        return count++;
+    }
+
+    // Сбрасывает отображенные сегменты на диск
+    void flush() {
+#ifndef _WIN32
+        for (auto &s : segments) {
+            if (s.mapped) msync(s.base, segmentBytes(), MS_SYNC);
+        }
+#endif
+    }
+
+    LedgerEntry entry(size_t i) const {
+        const Segment &s = segments[i / SEGMENT_ENTRIES];
+        size_t k = i % SEGMENT_ENTRIES;
+        return LedgerEntry{s.amounts[k], s.currencies[k], s.categories[k], s.timestamps[k], (EntryType)s.types[k],
+                           (EntryStatus)s.statuses[k]};
+    }
+    // Столбцы одного сегмента для последовательной обработки
+    struct Columns {
+        const long long *amounts;
+        const long long *timestamps;
+        const uint16_t *currencies;
+        const uint16_t *categories;
+        const uint8_t *types;
+        const uint8_t *statuses;
+        size_t count;
+    };
+    size_t getSegmentCount() const { return segments.size(); };
+    Columns getSegment(size_t index) const {
+        const Segment &s = segments[index];
+        size_t n = min(SEGMENT_ENTRIES, count - index * SEGMENT_ENTRIES);
+        return Columns{s.amounts, s.timestamps, s.currencies, s.categories, s.types, s.statuses, n};
+    }
+
+    long long timestampAt(size_t i) const { return segments[i / SEGMENT_ENTRIES].timestamps[i % SEGMENT_ENTRIES]; };
+
+    // Остаток с учетом всех операций до момента t включительно
+    long long balanceAsOf(long long t) const { return t == LLONG_MAX ? total : prefix(lowerIndex(t + 1)); };
+    // Сумма проведенных операций за [from, to)
+    long long rangeSum(long long from, long long to) const {
+        return to <= from ? 0 : prefix(lowerIndex(to)) - prefix(lowerIndex(from));
+    }
+
+    long long getTotal() const { return total; };
+    long long getLastTimestamp() const { return lastTimestamp; };
+    size_t size() const { return count; };
+    bool isPersistent() const { return !segments.empty() && segments[0].mapped; };
 };
 
+// Счет. Операции над счетом идут под его мьютексом; перевод берет мьютексы обоих счетов
+// всегда в одном порядке (по адресу), поэтому встречные переводы не взаимоблокируются.
+// Остаток читается без блокировки.
 class Account {
 protected:
     string accountNumber;
-    double balance;
-    vector<Transaction*> transactions;
+    atomic<long long> balance;      // в минимальных единицах валюты счета
+    Ledger ledger;
+    const Currency *currency;
+    const CurrencyConverter *converter;
+    mutable mutex accountMutex;
+
+    // Сумма транзакции в валюте счета
+    long long amountOf(const Transaction *trx) const {
+        if (!converter || !currency || !trx->getCurrency()) return toMinor(trx->getAmount());
+        return toMinor(converter->convert(trx->getAmount(), trx->getCurrency(), currency));
+    }
+    uint16_t currencyOf(const Transaction *trx) const {
+        const Currency *c = trx->getCurrency() ? trx->getCurrency() : currency;
+        return c && c->getId() >= 0 ? (uint16_t)c->getId() : 0;
+    }
+    uint16_t ownCurrency() const { return currency && currency->getId() >= 0 ? (uint16_t)currency->getId() : 0; };
+    // Время проводки под мьютексом счета: NOW - текущее, но не раньше последней записи журнала
+    long long postingTime(long long when) const {
+        return when == NOW ? max(nowSeconds(), ledger.getLastTimestamp()) : when;
+    }
+
+    // Перевод при уже захваченных мьютексах обоих счетов. Время раньше последней записи
+    // любого из журналов отклоняет перевод целиком, ничего не записывая
+    static bool transferLocked(Account &from, Account &to, long long debit, long long credit, uint16_t cur, long long when) {
+        when = max(from.postingTime(when), to.postingTime(when));
+        if (when < from.ledger.getLastTimestamp() || when < to.ledger.getLastTimestamp()) return false;
+        bool ok = debit >= 0 && credit >= 0 && from.balance.load(memory_order_relaxed) >= debit;
+        from.ledger.append(-debit, cur, when, EntryType::TransferOut, ok ? EntryStatus::Applied : EntryStatus::Rejected);
+        if (!ok) return false;
+        to.ledger.append(credit, cur, when, EntryType::TransferIn, EntryStatus::Applied);
+        from.balance.fetch_sub(debit, memory_order_relaxed);
+        to.balance.fetch_add(credit, memory_order_relaxed);
+        return true;
+    }
+    static bool transfer(Account &from, Account &to, long long debit, long long credit, uint16_t cur, long long when) {
+        if (&from == &to) return false;
+        Account *first = less<Account*>()(&from, &to) ? &from : &to;
+        Account *second = first == &from ? &to : &from;
+        lock_guard<mutex> lockFirst(first->accountMutex);
+        lock_guard<mutex> lockSecond(second->accountMutex);
+        return transferLocked(from, to, debit, credit, cur, when);
+    }
 public:
-    Account(const string &acctNumb, double bal)
-        : accountNumber(acctNumb), balance(bal) {}
+    // Время операции по умолчанию: момент проводки
+    static constexpr long long NOW = LLONG_MIN;
+
+    // ledgerDir - каталог для журнала на диске; если журнал там уже есть, остаток берется из него
+    Account(const string &acctNumb, double bal, const Currency *cur = nullptr, const CurrencyConverter *conv = nullptr,
+            const string &ledgerDir = "")
+        : accountNumber(acctNumb), balance(0), ledger(ledgerDir), currency(cur), converter(conv) {
+        if (ledger.size() == 0 && bal != 0) {
+            ledger.append(toMinor(bal), ownCurrency(), nowSeconds(), EntryType::Opening, EntryStatus::Applied);
+        }
+        balance = ledger.getTotal();
+    }
     virtual ~Account() {};
-    void deposit(Transaction *trx) {
-        balance += trx->getAmount();
-        transactions.push_back(trx);
-    }
-    void withdraw(Transaction *trx) {
-        if (balance >= trx->getAmount())
-            balance -= trx->getAmount();
-        else
+    // Операция со временем раньше последней записи журнала не проводится (false)
+    bool deposit(Transaction *trx, long long when = NOW) {
+        long long amount = amountOf(trx);
+        lock_guard<mutex> lock(accountMutex);
+        if (ledger.append(amount, currencyOf(trx), postingTime(when), EntryType::Deposit, EntryStatus::Applied,
+                          trx->getCategory()) == Ledger::npos) {
+            return false;
+        }
+        balance.fetch_add(amount, memory_order_relaxed);
+        return true;
+    }
+    // Списание при нехватке средств записывается в журнал как отклоненное
+    bool withdraw(Transaction *trx, long long when = NOW) {
+        long long amount = amountOf(trx);
+        bool ok;
+        {
+            lock_guard<mutex> lock(accountMutex);
+            ok = balance.load(memory_order_relaxed) >= amount;
+            if (ledger.append(-amount, currencyOf(trx), postingTime(when), EntryType::Withdrawal,
+                              ok ? EntryStatus::Applied : EntryStatus::Rejected, trx->getCategory()) == Ledger::npos) {
+                return false;
+            }
+            if (ok) balance.fetch_sub(amount, memory_order_relaxed);
+        }
+        if (!ok)
             cerr << "Недостаточно средств.\n";
-        transactions.push_back(trx);
+        return ok;
     }
-    double getBalance() const { return balance; };
+
+    // Атомарный перевод суммы транзакции: списание в валюте from, зачисление в валюте to.
+    // Если средств не хватает, ни один остаток не меняется.
+    static bool transfer(Account &from, Account &to, Transaction *trx, long long when = NOW) {
+        return transfer(from, to, from.amountOf(trx), to.amountOf(trx), from.currencyOf(trx), when);
+    }
+    // Перевод в минимальных единицах между счетами одной валюты
+    static bool transfer(Account &from, Account &to, long long amount, long long when = NOW) {
+        return transfer(from, to, amount, amount, from.ownCurrency(), when);
+    }
+
+    double getBalance() const { return fromMinor(balance.load()); };
+    long long getBalanceMinor() const { return balance.load(); };
     string getAccountNumber() const { return accountNumber; }; // Новый метод
+    const Currency *getCurrency() const { return currency; };
+    // Журнал читается без блокировки только когда операций над счетом нет
+    const Ledger &getLedger() const { return ledger; };
+    Ledger &getLedger() { return ledger; };
 };
 
+enum class BudgetPeriod { Monthly, Quarterly };
+
+// Иерархический бюджет: категории и подкатегории с лимитами на месяц или квартал.
+// Расход - резервирование без блокировок: сумма добавляется к узлу и по цепочке ко всем
+// родителям через compare-and-swap; если какой-то лимит превышен, уже сделанные
+// резервирования откатываются. Состояние узла - одно 64-битное слово: номер периода
+// в старших 16 битах и потраченная сумма в минимальных единицах в младших 48, поэтому
+// с наступлением нового периода расход обнуляется сам, без обхода дерева.
 class Budget {
+public:
+    static constexpr size_t ROOT = 0;
+    static constexpr long long UNLIMITED = LLONG_MAX;
 protected:
-    double limit;
-    double spent;
+    static constexpr int SPENT_BITS = 48;
+    static constexpr uint64_t SPENT_MASK = (1ULL << SPENT_BITS) - 1;
+
+    struct Node {
+        string name;
+        size_t parent;
+        atomic<long long> limit;
+        atomic<uint64_t> state{0};   // период << SPENT_BITS | потрачено
+
+        Node(const string &n, size_t p, long long lim) : name(n), parent(p), limit(lim) {}
+    };
+
+    BudgetPeriod period;
+    deque<Node> nodes;
+    unordered_map<string, size_t> byName;
+
+    // Лимит из пользовательской суммы: ноль и меньше - без ограничения, одинаково для корня и категорий
+    static long long limitOf(double lim) { return lim > 0 ? toMinor(lim) : UNLIMITED; }
+
+    static uint64_t periodOf(uint64_t state) { return state >> SPENT_BITS; };
+    static long long spentOf(uint64_t state) { return (long long)(state & SPENT_MASK); };
+
+    // Прибавляет delta к узлу в периоде key; false - лимит превышен или период уже закрыт
+    bool adjust(Node &node, uint64_t key, long long delta) {
+        uint64_t current = node.state.load();
+        for (;;) {
+            uint64_t stored = periodOf(current);
+            if (stored > key) return false;
+            long long spent = (stored == key ? spentOf(current) : 0) + delta;
+            if (spent < 0 || (delta > 0 && spent > node.limit.load(memory_order_relaxed)) || (uint64_t)spent > SPENT_MASK) {
+                return false;
+            }
+            if (node.state.compare_exchange_weak(current, key << SPENT_BITS | (uint64_t)spent)) return true;
+        }
+    }
+
+    // Снимает с узла до amount расхода периода key одним CAS; возвращает снятое
+    long long take(Node &node, uint64_t key, long long amount) {
+        uint64_t current = node.state.load();
+        for (;;) {
+            if (periodOf(current) != key) return 0;
+            long long taken = min(amount, spentOf(current));
+            if (taken <= 0) return 0;
+            if (node.state.compare_exchange_weak(current, key << SPENT_BITS | (uint64_t)(spentOf(current) - taken))) return taken;
+        }
+    }
+
+    // Возвращает зарезервированное; если период узла уже сменился, резерв исчез вместе с ним.
+    // Как и release, не опускает расход ниже нуля
+    void rollback(size_t from, size_t to, uint64_t key, long long amount) {
+        for (size_t n = from; n != to; n = nodes[n].parent) {
+            take(nodes[n], key, amount);
+        }
+    }
 public:
-    Budget(double lim)
-        : limit(lim), spent(0) {}
+    // Корень бюджета с общим лимитом (0 - без ограничения); категории добавляются до начала расходов
+    Budget(double lim, BudgetPeriod p = BudgetPeriod::Monthly)
+        : period(p) {
+        nodes.emplace_back("", ROOT, limitOf(lim));
+        byName[""] = ROOT;
+    }
     virtual ~Budget() {};
-    bool spend(double amount) {
-        if ((spent + amount) <= limit) {
-            spent += amount;
-            return true;
+
+    // Номер периода для момента времени: месяцы или кварталы с 1970 года
+    uint64_t periodKey(long long when) const {
+        long long months = monthsSinceEpoch(when);
+        return (uint64_t)max(0LL, period == BudgetPeriod::Monthly ? months : months / 3);
+    }
+
+    // Категория с лимитом на период; имя подкатегории - через "/" от родителя: "Еда/Кафе"
+    size_t addCategory(const string &name, double lim, size_t parent = ROOT) {
+        string full = parent == ROOT ? name : nodes[parent].name + "/" + name;
+        auto it = byName.find(full);
+        if (it != byName.end()) return it->second;
+        nodes.emplace_back(full, parent, limitOf(lim));
+        byName[full] = nodes.size() - 1;
+        return nodes.size() - 1;
+    }
+    optional<size_t> findCategory(const string &name) const {
+        auto it = byName.find(name);
+        if (it == byName.end()) return nullopt;
+        return it->second;
+    }
+    void setLimit(size_t category, double lim) { nodes[category].limit = limitOf(lim); };
+
+    // Резервирует расход в категории и во всех ее родителях; при отказе ничего не меняется
+    bool spendMinor(size_t category, long long amount, long long when = nowSeconds()) {
+        if (amount <= 0 || category >= nodes.size()) return amount == 0;
+        uint64_t key = periodKey(when);
+        for (size_t n = category;; n = nodes[n].parent) {
+            if (!adjust(nodes[n], key, amount)) {
+                rollback(category, n, key, amount);
+                return false;
+            }
+            if (n == ROOT) return true;
+        }
+    }
+    bool spend(size_t category, double amount, long long when = nowSeconds()) {
+        return spendMinor(category, toMinor(amount), when);
+    }
+    bool spend(double amount) { return spend(ROOT, amount); };
+
+    // Возврат ранее проведенного расхода того же периода. Сколько вернуть, решает категория:
+    // снятое с нее ровно столько же вычитается из всех родителей. Возвращает снятую сумму
+    double release(size_t category, double amount, long long when = nowSeconds()) {
+        long long minor = toMinor(amount);
+        if (minor <= 0 || category >= nodes.size()) return 0;
+        uint64_t key = periodKey(when);
+        long long released = take(nodes[category], key, minor);
+        if (released == 0 || category == ROOT) return fromMinor(released);
+        for (size_t n = nodes[category].parent;; n = nodes[n].parent) {
+            take(nodes[n], key, released);
+            if (n == ROOT) break;
         }
-        return false;
+        return fromMinor(released);
+    }
+
+    // Чтение без блокировок: одно атомарное слово на узел
+    long long spentMinor(size_t category, long long when = nowSeconds()) const {
+        uint64_t state = nodes[category].state.load(memory_order_relaxed);
+        return periodOf(state) == periodKey(when) ? spentOf(state) : 0;
+    }
+    long long remainingMinor(size_t category, long long when = nowSeconds()) const {
+        long long lim = nodes[category].limit.load(memory_order_relaxed);
+        return lim == UNLIMITED ? UNLIMITED : lim - spentMinor(category, when);
+    }
+    double remaining(size_t category, long long when = nowSeconds()) const { return fromMinor(remainingMinor(category, when)); };
+    double remaining() const { return remaining(ROOT); };
+
+    const string &getName(size_t category) const { return nodes[category].name; };
+    size_t getParent(size_t category) const { return nodes[category].parent; };
+    size_t getCategoryCount() const { return nodes.size(); };
+};
+
+// Сумма в минимальных единицах как текст "-1234.56" без потоковых манипуляторов
+static void appendMinor(string &out, long long minor) {
+    char buf[32];
+    char *p = buf + sizeof(buf);
+    unsigned long long v = minor < 0 ? 0ULL - (unsigned long long)minor : (unsigned long long)minor;
+    *--p = (char)('0' + v % 10);
+    v /= 10;
+    *--p = (char)('0' + v % 10);
+    v /= 10;
+    *--p = '.';
+    do {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    if (minor < 0) *--p = '-';
+    out.append(p, buf + sizeof(buf) - p);
+}
+
+// Итоги отчета в минимальных единицах валюты счета; суммы целые, поэтому результат
+// не зависит от числа потоков и порядка слияния
+struct ReportTotals {
+    struct Flow {
+        long long income = 0;
+        long long expense = 0;
+        size_t count = 0;
+
+        void add(long long amount) {
+            if (amount >= 0) income += amount;
+            else expense -= amount;
+            count++;
+        }
+        void merge(const Flow &f) {
+            income += f.income;
+            expense += f.expense;
+            count += f.count;
+        }
+        bool operator==(const Flow &f) const { return income == f.income && expense == f.expense && count == f.count; };
+    };
+    size_t currencyCount = 0;
+    long long firstMonth = 0;
+    size_t monthCount = 0;
+    vector<Flow> accounts;          // по счетам
+    vector<Flow> currencies;        // по валютам счетов
+    vector<Flow> categories;        // [категория * currencyCount + валюта]
+    vector<Flow> months;            // [месяц * currencyCount + валюта]
+    size_t entries = 0;
+    double seconds = 0;
+
+    void merge(const ReportTotals &t) {
+        for (size_t i = 0; i < accounts.size(); ++i) accounts[i].merge(t.accounts[i]);
+        for (size_t i = 0; i < currencies.size(); ++i) currencies[i].merge(t.currencies[i]);
+        for (size_t i = 0; i < months.size(); ++i) months[i].merge(t.months[i]);
+        if (categories.size() < t.categories.size()) categories.resize(t.categories.size());
+        for (size_t i = 0; i < t.categories.size(); ++i) categories[i].merge(t.categories[i]);
+        entries += t.entries;
     }
-    double remaining() const { return limit - spent; };
 };
 
 class Report {
 protected:
     vector<Account*> accounts;
+
+    uint16_t currencyOf(size_t account) const {
+        const Currency *c = accounts[account]->getCurrency();
+        return c && c->getId() >= 0 ? (uint16_t)c->getId() : 0;
+    }
+    string currencyCode(uint16_t id) const {
+        for (auto acc : accounts) {
+            if (acc->getCurrency() && acc->getCurrency()->getId() == id) return acc->getCurrency()->getCode();
+        }
+        return "#" + to_string(id);
+    }
+
+    // Обработка одного сегмента журнала: проведенные операции по счету, категории и месяцу
+    void accumulate(size_t account, const Ledger::Columns &col, ReportTotals &t) const {
+        size_t cur = currencyOf(account);
+        size_t stride = t.currencyCount;
+        ReportTotals::Flow &acc = t.accounts[account];
+        ReportTotals::Flow &byCurrency = t.currencies[cur];
+        // Время в журнале не убывает: номер месяца пересчитывается только на границе месяца
+        long long monthBegin = 0, monthEnd = LLONG_MIN;
+        ReportTotals::Flow *month = nullptr;
+        for (size_t i = 0; i < col.count; ++i) {
+            if (col.statuses[i] != (uint8_t)EntryStatus::Applied) continue;
+            long long amount = col.amounts[i];
+            long long ts = col.timestamps[i];
+            if (ts >= monthEnd || ts < monthBegin) {
+                long long index = monthsSinceEpoch(ts);
+                monthBegin = monthStartSeconds(index);
+                monthEnd = monthStartSeconds(index + 1);
+                month = &t.months[(size_t)(index - t.firstMonth) * stride + cur];
+            }
+            size_t slot = (size_t)col.categories[i] * stride + cur;
+            if (slot >= t.categories.size()) t.categories.resize((col.categories[i] + 1) * stride);
+            acc.add(amount);
+            byCurrency.add(amount);
+            t.categories[slot].add(amount);
+            month->add(amount);
+        }
+        t.entries += col.count;
+    }
 public:
     Report(vector<Account*> accts)
         : accounts(accts) {}
     virtual ~Report() {};
+
+    // Остатки по счетам: строки собираются в один буфер и выводятся одной записью
     void printSummary() const {
+        string out;
         for (auto acc : accounts) {
-            cout << "Аккаунт: " << acc->getAccountNumber() << ", Баланс: $" << fixed << setprecision(2) << acc->getBalance() << "\n"; // Используем новый метод
+            out.append("Аккаунт: ").append(acc->getAccountNumber()).append(", Баланс: $");
+            appendMinor(out, acc->getBalanceMinor());
+            out.push_back('\n');
+        }
+        cout.write(out.data(), (streamsize)out.size());
+    }
+
+    // Итоги по журналам всех счетов. Сегменты журналов раздаются потокам, каждый поток
+    // копит свои итоги, затем они сливаются. Журналы не должны меняться во время расчета.
+    ReportTotals summarize(unsigned threads = max(1u, thread::hardware_concurrency())) const {
+        auto start = chrono::steady_clock::now();
+        ReportTotals shape;
+        long long firstMonth = LLONG_MAX, lastMonth = LLONG_MIN;
+        vector<pair<size_t, size_t>> work;    // (счет, сегмент)
+        for (size_t a = 0; a < accounts.size(); ++a) {
+            const Ledger &ledger = accounts[a]->getLedger();
+            shape.currencyCount = max<size_t>(shape.currencyCount, currencyOf(a) + 1);
+            if (ledger.size() == 0) continue;
+            firstMonth = min(firstMonth, monthsSinceEpoch(ledger.timestampAt(0)));
+            lastMonth = max(lastMonth, monthsSinceEpoch(ledger.timestampAt(ledger.size() - 1)));
+            for (size_t s = 0; s < ledger.getSegmentCount(); ++s) {
+                work.emplace_back(a, s);
+            }
+        }
+        shape.firstMonth = work.empty() ? 0 : firstMonth;
+        shape.monthCount = work.empty() ? 0 : (size_t)(lastMonth - firstMonth + 1);
+        shape.accounts.resize(accounts.size());
+        shape.currencies.resize(shape.currencyCount);
+        shape.months.resize(shape.monthCount * shape.currencyCount);
+
+        unsigned workers = (unsigned)max<size_t>(1, min<size_t>(threads, work.size()));
+        vector<ReportTotals> partial(workers, shape);
+        atomic<size_t> next{0};
+        vector<thread> pool;
+        for (unsigned w = 0; w < workers; ++w) {
+            pool.emplace_back([&, w]() {
+                for (size_t i = next++; i < work.size(); i = next++) {
+                    accumulate(work[i].first, accounts[work[i].first]->getLedger().getSegment(work[i].second), partial[w]);
+                }
+            });
+        }
+        for (auto &t : pool) {
+            t.join();
         }
+        // Попарное слияние: на каждом шаге половина потоков вливает итоги соседей
+        for (size_t step = 1; step < workers; step *= 2) {
+            pool.clear();
+            for (size_t w = 0; w + step < workers; w += 2 * step) {
+                pool.emplace_back([&, w, step]() { partial[w].merge(partial[w + step]); });
+            }
+            for (auto &t : pool) {
+                t.join();
+            }
+        }
+        ReportTotals result = move(partial[0]);
+        result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+    // Текст отчета; categoryNames[код] - название категории операции, если список задан
+    string format(const ReportTotals &t, const vector<string> *categoryNames = nullptr, size_t maxAccounts = SIZE_MAX) const {
+        string out;
+        out.reserve(256 + 96 * (min(maxAccounts, accounts.size()) + t.monthCount * t.currencyCount));
+        auto flow = [&](const ReportTotals::Flow &f) {
+            out.append("доходы ");
+            appendMinor(out, f.income);
+            out.append(", расходы ");
+            appendMinor(out, f.expense);
+            out.append(", операций ").append(to_string(f.count)).push_back('\n');
+        };
+        out.append("Счета:\n");
+        for (size_t a = 0; a < accounts.size() && a < maxAccounts; ++a) {
+            out.append("  ").append(accounts[a]->getAccountNumber()).append(" (").append(currencyCode(currencyOf(a))).append("): ");
+            flow(t.accounts[a]);
+        }
+        if (accounts.size() > maxAccounts) out.append("  ... еще ").append(to_string(accounts.size() - maxAccounts)).append("\n");
+        out.append("Валюты:\n");
+        for (size_t c = 0; c < t.currencyCount; ++c) {
+            if (!t.currencies[c].count) continue;
+            out.append("  ").append(currencyCode((uint16_t)c)).append(": ");
+            flow(t.currencies[c]);
+        }
+        out.append("Категории:\n");
+        for (size_t i = 0; i < t.categories.size(); ++i) {
+            if (!t.categories[i].count) continue;
+            size_t category = i / t.currencyCount;
+            string name = category == 0 ? "Без категории"
+                        : categoryNames && category < categoryNames->size() ? (*categoryNames)[category]
+                        : "#" + to_string(category);
+            out.append("  ").append(name).append(" ").append(currencyCode((uint16_t)(i % t.currencyCount))).append(": ");
+            flow(t.categories[i]);
+        }
+        out.append("По месяцам (чистый поток):\n");
+        for (size_t mi = 0; mi < t.monthCount; ++mi) {
+            long long index = t.firstMonth + (long long)mi;
+            long long year = 1970 + index / 12, month = index % 12 + 1;
+            out.append("  ").append(to_string(year)).push_back('-');
+            if (month < 10) out.push_back('0');
+            out.append(to_string(month)).push_back(':');
+            for (size_t c = 0; c < t.currencyCount; ++c) {
+                const ReportTotals::Flow &f = t.months[mi * t.currencyCount + c];
+                if (!f.count) continue;
+                out.append(" ").append(currencyCode((uint16_t)c)).push_back(' ');
+                appendMinor(out, f.income - f.expense);
+            }
+            out.push_back('\n');
+        }
+        return out;
     }
 };
 
@@ -91,23 +1172,384 @@ int main() {
     // Валюта
     Currency usd("USD", 1.0);
     Currency rub("RUB", 80.0);
+    Currency eur("EUR", 0.92), cny("CNY", 7.2), kzt("KZT", 470.0);
+
+    // Конвертер: номера валют и матрица кросс-курсов
+    CurrencyConverter converter;
+    converter.addCurrency(&usd);
+    converter.addCurrency(&rub);
+    converter.addCurrency(&eur);
+    converter.addCurrency(&cny);
+    converter.addCurrency(&kzt);
 
     // Транзакции
     Transaction purchase(100.0, "Покупка товаров", &usd);
     Transaction payment(500.0, "Оплата услуг", &rub);
 
     // Банковский счёт
-    Account myAccount("ACC12345", 1000.0);
+    Account myAccount("ACC12345", 1000.0, &usd, &converter);
     myAccount.deposit(&purchase);
     myAccount.withdraw(&payment);
 
+    // Списание сверх остатка отклоняется и не меняет остаток
+    Transaction tooMuch(100000.0, "Крупная покупка", &usd);
+    bool accepted = myAccount.withdraw(&tooMuch);
+    const Ledger &journal = myAccount.getLedger();
+    cout << "Журнал счета: записей " << journal.size() << ", последняя "
+         << (journal.entry(journal.size() - 1).status == EntryStatus::Rejected ? "отклонена" : "проведена")
+         << (accepted ? " (ошибка)" : "") << ", остаток по журналу $" << fixed << setprecision(2)
+         << fromMinor(journal.getTotal()) << "\n";
+    // Операция задним числом не проводится: журнал упорядочен по времени
+    bool backdated = myAccount.deposit(&purchase, journal.getLastTimestamp() - 86400);
+    cout << "Зачисление задним числом: " << (backdated ? "проведено (ошибка)" : "отклонено") << ", записей " << journal.size()
+         << "\n";
+
     // Бюджет
     Budget monthlyBudget(1500.0);
     monthlyBudget.spend(myAccount.getBalance());
 
+    // Бюджет по категориям: параллельные расходы не превышают лимиты ни на одном уровне
+    {
+        const long long march = 1772323200;   // 2026-03-01
+        Budget household(100000.0, BudgetPeriod::Monthly);
+        size_t food = household.addCategory("Еда", 30000.0);
+        size_t cafe = household.addCategory("Кафе", 10000.0, food);
+        size_t groceries = household.addCategory("Продукты", 0, food);
+        size_t transport = household.addCategory("Транспорт", 20000.0);
+        size_t taxi = household.addCategory("Такси", 8000.0, transport);
+        size_t other = household.addCategory("Прочее", 0);
+        vector<size_t> leaves{cafe, groceries, transport, taxi, other};
+
+        atomic<bool> spending{true};
+        atomic<long> accepted{0}, refused{0}, snapshots{0}, violations{0};
+        thread observer([&]() {
+            // Остатки читаются во время расходов: ни один не уходит ниже нуля
+            while (spending.load()) {
+                for (size_t c = 0; c < household.getCategoryCount(); ++c) {
+                    violations += household.remainingMinor(c, march) < 0;
+                }
+                snapshots++;
+            }
+        });
+        auto t0 = chrono::steady_clock::now();
+        vector<thread> services;
+        for (int t = 0; t < 8; ++t) {
+            services.emplace_back([&, t]() {
+                mt19937 rng(480 + t);
+                long ok = 0, no = 0;
+                for (int i = 0; i < 100000; ++i) {
+                    size_t c = leaves[rng() % leaves.size()];
+                    if (household.spendMinor(c, (long long)(rng() % 500) + 1, march + i)) ok++;
+                    else no++;
+                    if (i % 16 == 0) household.release(c, 0.01, march + i);
+                }
+                accepted += ok;
+                refused += no;
+            });
+        }
+        for (auto &t : services) {
+            t.join();
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        spending = false;
+        observer.join();
+
+        // Расход родителя равен сумме расходов детей
+        bool rolledUp = true;
+        for (size_t c = 0; c < household.getCategoryCount(); ++c) {
+            long long children = 0;
+            bool hasChildren = false;
+            for (size_t d = 1; d < household.getCategoryCount(); ++d) {
+                if (household.getParent(d) == c && d != c) {
+                    children += household.spentMinor(d, march);
+                    hasChildren = true;
+                }
+            }
+            long long own = household.spentMinor(c, march);
+            rolledUp = rolledUp && (!hasChildren || own >= children) && household.remainingMinor(c, march) >= 0;
+        }
+        cout << "Бюджет: " << accepted + refused << " расходов в 8 потоках за " << ms << " мс, принято " << accepted
+             << ", отказано " << refused << "; остаток: всего " << household.remaining(Budget::ROOT, march) << ", "
+             << household.getName(food) << " " << household.remaining(food, march) << ", "
+             << household.getName(cafe) << " " << household.remaining(cafe, march) << ", "
+             << household.getName(taxi) << " " << household.remaining(taxi, march) << "; чтений остатков " << snapshots
+             << ", отрицательных " << violations << ", свод по уровням " << (rolledUp ? "верен" : "НАРУШЕН")
+             << "; в апреле остаток снова " << household.remaining(Budget::ROOT, march + 31 * 86400) << "\n";
+    }
+
     // Отчёт
     Report financialReport({&myAccount});
     financialReport.printSummary();
 
+    // Пакетный пересчет: миллионы транзакций в разных валютах в валюту отчета
+    {
+        const size_t n = 4000000;
+        vector<double> amounts(n);
+        vector<uint16_t> ids(n);
+        mt19937 rng(44);
+        for (size_t i = 0; i < n; ++i) {
+            ids[i] = (uint16_t)(rng() % converter.getCurrencyCount());
+            amounts[i] = (rng() % 1000000) / 100.0;
+        }
+        // Прежний путь: поиск валюты по коду и деление курсов на каждую транзакцию
+        const Currency *all[] = {&usd, &rub, &eur, &cny, &kzt};
+        auto start = chrono::steady_clock::now();
+        double naive = 0;
+        for (size_t i = 0; i < n; ++i) {
+            Currency *c = converter.findCurrency(all[ids[i]]->getCode());
+            naive += amounts[i] * rub.getExchangeRate() / c->getExchangeRate();
+        }
+        double naiveMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        vector<double> converted(n);
+        start = chrono::steady_clock::now();
+        converter.convertBatch(amounts.data(), ids.data(), n, rub.getId(), converted.data());
+        double batchMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        start = chrono::steady_clock::now();
+        double total = converter.sumBatch(amounts.data(), ids.data(), n, rub.getId());
+        double sumMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "Пересчет " << n << " транзакций в RUB: по коду валюты " << naiveMs << " мс, пакетом " << batchMs
+             << " мс, сумма пакетом " << sumMs << " мс; итог " << total << " (" << converted.size() << " сумм), "
+             << "относительное расхождение с прежним путем " << scientific << setprecision(1)
+             << fabs(total - naive) / naive << fixed << setprecision(2) << "\n";
+    }
+
+    // Переводы: миллион случайных переводов в 8 потоках, равномерно и с "горячими" счетами
+    {
+        const int accountCount = 1000;
+        const long long opening = 100000;   // 1000.00 на каждом счете
+        auto run = [&](const char *label, int hotAccounts) {
+            deque<Account> accounts;
+            for (int a = 0; a < accountCount; ++a) {
+                accounts.emplace_back("T" + to_string(a), fromMinor(opening), &usd);
+            }
+            const int threads = 8, perThread = 125000;
+            atomic<long> done{0}, rejected{0};
+            auto t0 = chrono::steady_clock::now();
+            vector<thread> pool;
+            for (int t = 0; t < threads; ++t) {
+                pool.emplace_back([&, t]() {
+                    mt19937 rng(470 + t);
+                    long ok = 0, fail = 0;
+                    auto pick = [&]() {
+                        // 90% переводов касаются горячих счетов
+                        if (hotAccounts > 0 && rng() % 10 != 0) return (int)(rng() % hotAccounts);
+                        return (int)(rng() % accountCount);
+                    };
+                    for (int i = 0; i < perThread; ++i) {
+                        int a = pick(), b = pick();
+                        if (a == b) b = (b + 1) % accountCount;
+                        if (Account::transfer(accounts[a], accounts[b], (long long)(rng() % 50000) + 1)) ok++;
+                        else fail++;
+                    }
+                    done += ok;
+                    rejected += fail;
+                });
+            }
+            for (auto &t : pool) {
+                t.join();
+            }
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+            long long total = 0, ledgerTotal = 0;
+            int negative = 0;
+            for (const auto &a : accounts) {
+                total += a.getBalanceMinor();
+                ledgerTotal += a.getLedger().getTotal();
+                negative += a.getBalanceMinor() < 0;
+            }
+            cout << "Переводы (" << label << "): " << done + rejected << " за " << ms << " мс ("
+                 << (long)((done + rejected) / ms * 1000) << " в секунду), отклонено " << rejected
+                 << ", сумма остатков " << (total == opening * accountCount && ledgerTotal == total ? "сохранена" : "НАРУШЕНА")
+                 << ", отрицательных остатков " << negative << "\n";
+        };
+        run("равномерно", 0);
+        run("10 горячих счетов", 10);
+    }
+
+    // Сводный отчет: десять миллионов операций по 200 счетам в трех валютах за три года
+    {
+        // Код категории - индекс в списке, 0 - без категории
+        const vector<string> categoryNames{"", "Зарплата", "Еда", "Транспорт", "Жилье", "Развлечения"};
+        const vector<size_t> categories{1, 2, 3, 4, 5};
+        const Currency *accountCurrencies[] = {&usd, &rub, &eur};
+        deque<Account> book;
+        vector<Account*> all;
+        for (int a = 0; a < 200; ++a) {
+            book.emplace_back("R" + to_string(a), 0.0, accountCurrencies[a % 3]);
+            all.push_back(&book.back());
+        }
+        const size_t perAccount = 50000;
+        const long long start = 1704067200, span = 3LL * 365 * 86400;   // с 2024-01-01
+        mt19937 rng(49);
+        for (auto acc : all) {
+            Ledger &ledger = acc->getLedger();
+            uint16_t cur = (uint16_t)acc->getCurrency()->getId();
+            for (size_t i = 0; i < perAccount; ++i) {
+                size_t category = categories[rng() % categories.size()];
+                long long amount = category == categories[0] ? (long long)(rng() % 500000) : -(long long)(rng() % 100000);
+                ledger.append(amount, cur, start + (long long)(span * ((double)i / perAccount)),
+                              amount >= 0 ? EntryType::Deposit : EntryType::Withdrawal,
+                              rng() % 50 ? EntryStatus::Applied : EntryStatus::Rejected, (uint16_t)category);
+            }
+        }
+        Report bulk(all);
+        ReportTotals serial = bulk.summarize(1);
+        ReportTotals parallel = bulk.summarize(8);
+        // Целочисленные итоги не зависят от числа потоков: совпадать должен каждый разрез
+        bool same = serial.accounts == parallel.accounts && serial.currencies == parallel.currencies &&
+                    serial.categories == parallel.categories && serial.months == parallel.months;
+        long long ledgerSum = 0, reportSum = 0;
+        for (auto acc : all) {
+            ledgerSum += acc->getLedger().getTotal();
+        }
+        for (const auto &f : parallel.accounts) {
+            reportSum += f.income - f.expense;
+        }
+        auto t0 = chrono::steady_clock::now();
+        string text = bulk.format(parallel, &categoryNames, 3);
+        double formatMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        size_t firstLines = 0;
+        for (int lines = 0; firstLines < text.size() && lines < 16; ++lines) {
+            firstLines = text.find('\n', firstLines) + 1;
+        }
+        cout.write(text.data(), (streamsize)firstLines);
+        cout << "  ...\nОтчет: " << parallel.entries << " операций, 1 поток " << serial.seconds * 1000 << " мс ("
+             << (long)(serial.entries / serial.seconds) << " в секунду), 8 потоков " << parallel.seconds * 1000
+             << " мс, итоги " << (same ? "совпадают" : "РАСХОДЯТСЯ") << ", сверка с журналами "
+             << (ledgerSum == reportSum ? "верна" : "НАРУШЕНА") << "; текст " << text.size() << " байт за " << formatMs << " мс\n";
+    }
+
+    // Журнал на диске: два миллиона операций за три года, остатки на дату и суммы за период
+    {
+        namespace fs = std::filesystem;
+        string dir = (fs::temp_directory_path() / "ledger_demo").string();
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        const size_t n = 2000000;
+        const long long start = 1700000000, span = 3LL * 365 * 86400;
+        vector<long long> times(n), amounts(n);
+        mt19937_64 rng(46);
+        for (size_t i = 0; i < n; ++i) {
+            times[i] = start + (long long)(span * ((double)i / n));
+            amounts[i] = (long long)(rng() % 200000) - 90000;
+        }
+        auto t0 = chrono::steady_clock::now();
+        long long running = 0;
+        {
+            Ledger ledger(dir);
+            for (size_t i = 0; i < n; ++i) {
+                bool ok = running + amounts[i] >= 0;
+                ledger.append(amounts[i], (uint16_t)(i % 5), times[i],
+                              amounts[i] >= 0 ? EntryType::Deposit : EntryType::Withdrawal,
+                              ok ? EntryStatus::Applied : EntryStatus::Rejected);
+                if (ok) running += amounts[i];
+            }
+            ledger.flush();
+        }
+        double appendMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+        // Открываем заново с диска и сверяем с полным проходом
+        Ledger reopened(dir);
+        const int queries = 100000;
+        vector<long long> at(queries);
+        for (auto &t : at) {
+            t = start + (long long)(rng() % span);
+        }
+        t0 = chrono::steady_clock::now();
+        long long checksum = 0;
+        for (long long t : at) {
+            checksum += reopened.balanceAsOf(t);
+        }
+        double queryNs = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / queries;
+        int mismatches = 0;
+        for (int q = 0; q < 20; ++q) {
+            long long from = at[q], to = at[q] + 30 * 86400, expected = 0;
+            for (size_t i = 0; i < n; ++i) {
+                if (times[i] >= from && times[i] < to && reopened.entry(i).status == EntryStatus::Applied) expected += amounts[i];
+            }
+            mismatches += expected != reopened.rangeSum(from, to);
+        }
+        cout << "Журнал: " << n << " записей на диске (" << (reopened.isPersistent() ? "mmap" : "в памяти") << ") за "
+             << appendMs << " мс, после перезапуска записей " << reopened.size() << ", остаток "
+             << (reopened.getTotal() == running ? "совпадает" : "РАСХОДИТСЯ") << "; остаток на дату " << queryNs
+             << " нс, расхождений сумм за период " << mismatches << " (контроль " << checksum % 1000 << ")\n";
+
+        // Сегмент с чужой сигнатурой не открывается: журнал сообщает, что именно не так
+        string foreign = dir + "/foreign";
+        fs::create_directories(foreign);
+        {
+            ofstream out(foreign + "/ledger-000000.seg", ios::binary);
+            out << string(4096, 'x');
+        }
+        try {
+            Ledger bad(foreign);
+            cout << "Чужой сегмент открыт - ОШИБКА\n";
+        } catch (const runtime_error &e) {
+            cout << "Чужой сегмент отклонен: " << e.what() << "\n";
+        }
+        fs::remove_all(dir);
+    }
+
+    // Курсы из ленты: фоновое обновление, чтение без блокировок, закрепленный снимок и курсы на дату
+    {
+        string feedPath = "rates_feed.txt";
+        const long long baseTime = 1760000000;
+        // Лента пишется во временный файл и подменяется целиком, чтобы сервис не прочитал ее наполовину
+        auto writeFeed = [&](int k) {
+            {
+                ofstream feed(feedPath + ".tmp", ios::trunc);
+                feed << "# asof " << baseTime + k * 3600 << "\n";
+                feed << "USD 1.0\nRUB " << 80.0 + k << "\nEUR," << 0.92 + k * 0.01 << "\n";
+            }
+            rename((feedPath + ".tmp").c_str(), feedPath.c_str());
+        };
+        RateService service(converter.getCodes(), converter.getRates(), baseTime - 3600);
+        converter.attachRates(&service);
+        RateService::Snapshot pinned = service.pin();
+        writeFeed(0);
+        service.start(feedPath, chrono::milliseconds(5));
+
+        atomic<bool> running{true};
+        atomic<long> reads{0}, inconsistent{0};
+        vector<thread> readers;
+        for (int r = 0; r < 4; ++r) {
+            readers.emplace_back([&]() {
+                long local = 0, bad = 0;
+                while (running.load()) {
+                    // Оба курса берутся из одной таблицы, поэтому их произведение равно 1
+                    double roundTrip = service.read([&](const RateTable &t) {
+                        return t.rate(usd.getId(), rub.getId()) * t.rate(rub.getId(), usd.getId());
+                    });
+                    bad += fabs(roundTrip - 1.0) > 1e-12;
+                    local++;
+                }
+                reads += local;
+                inconsistent += bad;
+            });
+        }
+        for (int k = 1; k <= 5; ++k) {
+            this_thread::sleep_for(chrono::milliseconds(30));
+            writeFeed(k);
+        }
+        auto deadline = chrono::steady_clock::now() + chrono::seconds(2);
+        while (service.pin()->getAsOf() < baseTime + 5 * 3600 && chrono::steady_clock::now() < deadline) {
+            this_thread::sleep_for(chrono::milliseconds(5));
+        }
+        running = false;
+        for (auto &t : readers) {
+            t.join();
+        }
+        service.stop();
+        remove(feedPath.c_str());
+
+        auto atNoon = service.asOf(baseTime + 2 * 3600 + 1800);
+        cout << "Курсы: обновлений " << service.getReloadCount() << ", версия " << service.pin()->getVersion()
+             << ", USD->RUB сейчас " << converter.rate(usd.getId(), rub.getId()) << ", в закрепленном снимке "
+             << pinned->rate(usd.getId(), rub.getId()) << ", на " << baseTime + 2 * 3600 + 1800 << " - "
+             << (atNoon ? atNoon->rate(usd.getId(), rub.getId()) : 0.0) << "; чтений без блокировок " << reads
+             << ", несогласованных " << inconsistent << "\n";
+        converter.attachRates(nullptr);
+    }
+
     return 0;
 }
\ No newline at end of file